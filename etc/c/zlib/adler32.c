@@ -9,6 +9,24 @@
 
 local uLong adler32_combine_ OF((uLong adler1, uLong adler2, z_off64_t len2));
 
+/* Vectorized Adler-32, selected at run time by z_cpu_features() */
+#ifdef Z_X86_SIMD
+#  define ADLER32_SSSE3
+   local uLong adler32_ssse3 OF((unsigned long adler, unsigned long sum2,
+                                 const Bytef *buf, z_size_t len));
+#  if !defined(_MSC_VER) || _MSC_VER >= 1700
+#    define ADLER32_AVX2
+     local uLong adler32_avx2 OF((unsigned long adler, unsigned long sum2,
+                                  const Bytef *buf, z_size_t len));
+#  endif
+#endif
+#ifdef Z_ARM_SIMD
+#  define ADLER32_NEON
+   local uLong adler32_neon OF((unsigned long adler, unsigned long sum2,
+                                const Bytef *buf, z_size_t len));
+#endif
+#define SIMD_MIN 64             /* shortest input worth vectorizing */
+
 #define BASE 65521U     /* largest prime smaller than 65536 */
 #define NMAX 5552
 /* NMAX is the largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1 */
@@ -99,6 +117,19 @@ uLong ZEXPORT adler32_z(adler, buf, len)
         return adler | (sum2 << 16);
     }
 
+#ifdef ADLER32_AVX2
+    if (len >= SIMD_MIN && (z_cpu_features() & Z_CPU_AVX2))
+        return adler32_avx2(adler, sum2, buf, len);
+#endif
+#ifdef ADLER32_SSSE3
+    if (len >= SIMD_MIN && (z_cpu_features() & Z_CPU_SSSE3))
+        return adler32_ssse3(adler, sum2, buf, len);
+#endif
+#ifdef ADLER32_NEON
+    if (len >= SIMD_MIN)
+        return adler32_neon(adler, sum2, buf, len);
+#endif
+
     /* do length NMAX blocks -- requires just one modulo operation */
     while (len >= NMAX) {
         len -= NMAX;
@@ -130,6 +161,242 @@ uLong ZEXPORT adler32_z(adler, buf, len)
     return adler | (sum2 << 16);
 }
 
+/*
+   The vectorized versions work on blocks of BLOCK bytes.  For a block
+   b[0..BLOCK-1], the first sum grows by the sum of the bytes, and the second
+   sum grows by BLOCK times the first sum before the block plus the sum of
+   (BLOCK - i) * b[i].  The byte sums and the weighted sums are accumulated in
+   32-bit lanes, and the BLOCK times first sum terms are gathered in ps and
+   multiplied in once per run of blocks.  A run is at most NMAX bytes, so that
+   the lanes cannot overflow before the sums are reduced modulo BASE.  Any
+   bytes left over after the last whole block are added one at a time.
+ */
+#define ADLER_TAIL(adler, sum2, buf, len) \
+    do { \
+        if (len) { \
+            while (len >= 16) { \
+                len -= 16; \
+                DO16(buf); \
+                buf += 16; \
+            } \
+            while (len--) { \
+                adler += *buf++; \
+                sum2 += adler; \
+            } \
+            MOD(adler); \
+            MOD(sum2); \
+        } \
+    } while (0)
+
+#if defined(ADLER32_SSSE3) || defined(ADLER32_AVX2)
+#  include <immintrin.h>
+
+/* ========================================================================= */
+/* return the sum of the four 32-bit lanes of v */
+Z_TARGET("ssse3")
+local unsigned long hsum128(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return (unsigned)_mm_cvtsi128_si32(v);
+}
+#endif
+
+#ifdef ADLER32_SSSE3
+
+/* ========================================================================= */
+Z_TARGET("ssse3")
+local uLong adler32_ssse3(adler, sum2, buf, len)
+    unsigned long adler;
+    unsigned long sum2;
+    const Bytef *buf;
+    z_size_t len;
+{
+    z_size_t blocks;
+    unsigned n;
+    __m128i ps, s1, s2;
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+#  define BLOCK 32
+    blocks = len / BLOCK;
+    len -= blocks * BLOCK;
+    while (blocks) {
+        n = NMAX / BLOCK;
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        ps = _mm_cvtsi32_si128((int)(adler * n));
+        s2 = _mm_cvtsi32_si128((int)sum2);
+        s1 = zero;
+        do {
+            const __m128i b1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i b2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+
+            ps = _mm_add_epi32(ps, s1);
+            s1 = _mm_add_epi32(s1, _mm_sad_epu8(b1, zero));
+            s2 = _mm_add_epi32(s2,
+                               _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+            s1 = _mm_add_epi32(s1, _mm_sad_epu8(b2, zero));
+            s2 = _mm_add_epi32(s2,
+                               _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+            buf += BLOCK;
+        } while (--n);
+        s2 = _mm_add_epi32(s2, _mm_slli_epi32(ps, 5));
+
+        adler += hsum128(s1);
+        sum2 = hsum128(s2);
+        MOD(adler);
+        MOD(sum2);
+    }
+#  undef BLOCK
+
+    ADLER_TAIL(adler, sum2, buf, len);
+    return adler | (sum2 << 16);
+}
+
+#endif /* ADLER32_SSSE3 */
+
+#ifdef ADLER32_AVX2
+
+/* ========================================================================= */
+Z_TARGET("avx2")
+local uLong adler32_avx2(adler, sum2, buf, len)
+    unsigned long adler;
+    unsigned long sum2;
+    const Bytef *buf;
+    z_size_t len;
+{
+    z_size_t blocks;
+    unsigned n;
+    __m256i ps, s1, s2;
+    const __m256i tap1 = _mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57,
+                                          56, 55, 54, 53, 52, 51, 50, 49,
+                                          48, 47, 46, 45, 44, 43, 42, 41,
+                                          40, 39, 38, 37, 36, 35, 34, 33);
+    const __m256i tap2 = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                          24, 23, 22, 21, 20, 19, 18, 17,
+                                          16, 15, 14, 13, 12, 11, 10, 9,
+                                          8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+#  define BLOCK 64
+    blocks = len / BLOCK;
+    len -= blocks * BLOCK;
+    while (blocks) {
+        n = NMAX / BLOCK;
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        ps = _mm256_setr_epi32((int)(adler * n), 0, 0, 0, 0, 0, 0, 0);
+        s2 = _mm256_setr_epi32((int)sum2, 0, 0, 0, 0, 0, 0, 0);
+        s1 = zero;
+        do {
+            const __m256i b1 = _mm256_loadu_si256((const __m256i *)buf);
+            const __m256i b2 = _mm256_loadu_si256((const __m256i *)(buf + 32));
+
+            ps = _mm256_add_epi32(ps, s1);
+            s1 = _mm256_add_epi32(s1, _mm256_sad_epu8(b1, zero));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(
+                                      _mm256_maddubs_epi16(b1, tap1), ones));
+            s1 = _mm256_add_epi32(s1, _mm256_sad_epu8(b2, zero));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(
+                                      _mm256_maddubs_epi16(b2, tap2), ones));
+            buf += BLOCK;
+        } while (--n);
+        s2 = _mm256_add_epi32(s2, _mm256_slli_epi32(ps, 6));
+
+        adler += hsum128(_mm_add_epi32(_mm256_castsi256_si128(s1),
+                                       _mm256_extracti128_si256(s1, 1)));
+        sum2 = hsum128(_mm_add_epi32(_mm256_castsi256_si128(s2),
+                                     _mm256_extracti128_si256(s2, 1)));
+        MOD(adler);
+        MOD(sum2);
+    }
+#  undef BLOCK
+
+    ADLER_TAIL(adler, sum2, buf, len);
+    return adler | (sum2 << 16);
+}
+
+#endif /* ADLER32_AVX2 */
+
+#ifdef ADLER32_NEON
+#  include <arm_neon.h>
+
+/* ========================================================================= */
+local uLong adler32_neon(adler, sum2, buf, len)
+    unsigned long adler;
+    unsigned long sum2;
+    const Bytef *buf;
+    z_size_t len;
+{
+    z_size_t blocks;
+    unsigned n;
+    uint32x4_t ps, s1;
+    uint32x2_t t;
+    uint16x8_t c1, c2, c3, c4;
+    static const uint16_t taps[32] = {
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+
+#  define BLOCK 32
+    blocks = len / BLOCK;
+    len -= blocks * BLOCK;
+    while (blocks) {
+        n = NMAX / BLOCK;
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        /* the weighted sums are kept per column, 16 bits wide */
+        ps = vsetq_lane_u32((uint32_t)(adler * n), vdupq_n_u32(0), 0);
+        s1 = vdupq_n_u32(0);
+        c1 = c2 = c3 = c4 = vdupq_n_u16(0);
+        do {
+            const uint8x16_t b1 = vld1q_u8(buf);
+            const uint8x16_t b2 = vld1q_u8(buf + 16);
+
+            ps = vaddq_u32(ps, s1);
+            s1 = vpadalq_u16(s1, vpadalq_u8(vpaddlq_u8(b1), b2));
+            c1 = vaddw_u8(c1, vget_low_u8(b1));
+            c2 = vaddw_u8(c2, vget_high_u8(b1));
+            c3 = vaddw_u8(c3, vget_low_u8(b2));
+            c4 = vaddw_u8(c4, vget_high_u8(b2));
+            buf += BLOCK;
+        } while (--n);
+        ps = vshlq_n_u32(ps, 5);
+        ps = vmlal_u16(ps, vget_low_u16(c1), vld1_u16(taps));
+        ps = vmlal_u16(ps, vget_high_u16(c1), vld1_u16(taps + 4));
+        ps = vmlal_u16(ps, vget_low_u16(c2), vld1_u16(taps + 8));
+        ps = vmlal_u16(ps, vget_high_u16(c2), vld1_u16(taps + 12));
+        ps = vmlal_u16(ps, vget_low_u16(c3), vld1_u16(taps + 16));
+        ps = vmlal_u16(ps, vget_high_u16(c3), vld1_u16(taps + 20));
+        ps = vmlal_u16(ps, vget_low_u16(c4), vld1_u16(taps + 24));
+        ps = vmlal_u16(ps, vget_high_u16(c4), vld1_u16(taps + 28));
+
+        t = vpadd_u32(vpadd_u32(vget_low_u32(s1), vget_high_u32(s1)),
+                      vpadd_u32(vget_low_u32(ps), vget_high_u32(ps)));
+        adler += vget_lane_u32(t, 0);
+        sum2 += vget_lane_u32(t, 1);
+        MOD(adler);
+        MOD(sum2);
+    }
+#  undef BLOCK
+
+    ADLER_TAIL(adler, sum2, buf, len);
+    return adler | (sum2 << 16);
+}
+
+#endif /* ADLER32_NEON */
+
 /* ========================================================================= */
 uLong ZEXPORT adler32(adler, buf, len)
     uLong adler;
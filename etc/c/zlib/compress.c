@@ -84,3 +84,136 @@ uLong ZEXPORT compressBound (sourceLen)
     return sourceLen + (sourceLen >> 12) + (sourceLen >> 14) +
            (sourceLen >> 25) + 13;
 }
+
+/* ===========================================================================
+     Compresses one chunk of a larger stream as raw deflate data, so that
+   chunks can be compressed independently and then concatenated.  See the
+   description in zlib.h.
+ */
+int ZEXPORT deflateChunk (dest, destLen, source, sourceLen, dictionary,
+                          dictLength, level, last)
+    Bytef *dest;
+    uLongf *destLen;
+    const Bytef *source;
+    uLong sourceLen;
+    const Bytef *dictionary;
+    uInt dictLength;
+    int level;
+    int last;
+{
+    z_stream stream;
+    int err, flush;
+    const uInt max = (uInt)-1;
+    uLong left;
+
+    left = *destLen;
+    *destLen = 0;
+
+    stream.zalloc = (alloc_func)0;
+    stream.zfree = (free_func)0;
+    stream.opaque = (voidpf)0;
+
+    err = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                       Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) return err;
+    if (dictLength) {
+        err = deflateSetDictionary(&stream, dictionary, dictLength);
+        if (err != Z_OK) {
+            deflateEnd(&stream);
+            return err;
+        }
+    }
+
+    stream.next_out = dest;
+    stream.avail_out = 0;
+    stream.next_in = (z_const Bytef *)source;
+    stream.avail_in = 0;
+
+    for (;;) {
+        if (stream.avail_out == 0) {
+            stream.avail_out = left > (uLong)max ? max : (uInt)left;
+            left -= stream.avail_out;
+        }
+        if (stream.avail_in == 0) {
+            stream.avail_in = sourceLen > (uLong)max ? max : (uInt)sourceLen;
+            sourceLen -= stream.avail_in;
+        }
+        flush = sourceLen || stream.avail_in ? Z_NO_FLUSH :
+                last ? Z_FINISH : Z_SYNC_FLUSH;
+        err = deflate(&stream, flush);
+        if (err != Z_OK)
+            break;
+        /* a sync flush is complete once deflate() leaves output space */
+        if (flush == Z_SYNC_FLUSH && stream.avail_out != 0)
+            break;
+    }
+
+    *destLen = stream.total_out;
+    deflateEnd(&stream);
+    return err == Z_STREAM_END ? Z_OK : err;
+}
+
+/* ===========================================================================
+     An empty stored block, used to end a chunk at a byte boundary, is at most
+   five bytes, and compressBound() already pays for a zlib header and trailer.
+ */
+uLong ZEXPORT deflateChunkBound (sourceLen)
+    uLong sourceLen;
+{
+    return compressBound(sourceLen) + 5;
+}
+
+/* ===========================================================================
+     Compresses a batch of buffers, each into a stream of its own, reusing the
+   one deflate state.  See the description in zlib.h.
+ */
+int ZEXPORT deflateBatch (strm, count, sources, sourceLens, dest, destLen,
+                          offsets)
+    z_streamp strm;
+    unsigned count;
+    const Bytef * const *sources;
+    const uLong *sourceLens;
+    Bytef *dest;
+    uLongf *destLen;
+    uLongf *offsets;
+{
+    int err;
+    unsigned i;
+    const uInt max = (uInt)-1;
+    uLong left, sourceLen, total;
+
+    left = *destLen;
+    *destLen = 0;
+    total = 0;
+
+    for (i = 0; i < count; i++) {
+        offsets[i] = total;
+        err = deflateReset(strm);
+        if (err != Z_OK) return err;
+
+        strm->next_out = dest + total;
+        strm->avail_out = 0;
+        strm->next_in = (z_const Bytef *)sources[i];
+        strm->avail_in = 0;
+        sourceLen = sourceLens[i];
+
+        do {
+            if (strm->avail_out == 0) {
+                strm->avail_out = left > (uLong)max ? max : (uInt)left;
+                left -= strm->avail_out;
+            }
+            if (strm->avail_in == 0) {
+                strm->avail_in = sourceLen > (uLong)max ? max : (uInt)sourceLen;
+                sourceLen -= strm->avail_in;
+            }
+            err = deflate(strm, sourceLen ? Z_NO_FLUSH : Z_FINISH);
+        } while (err == Z_OK);
+        if (err != Z_STREAM_END) return err;
+
+        left += strm->avail_out;
+        total += strm->total_out;
+        *destLen = total;
+    }
+    offsets[count] = total;
+    return Z_OK;
+}
@@ -12,13 +12,12 @@
 /* @(#) $Id$ */
 
 /*
-  Note on the use of DYNAMIC_CRC_TABLE: there is no mutex or semaphore
-  protection on the static variables used to control the first-use generation
-  of the crc tables.  Therefore, if you #define DYNAMIC_CRC_TABLE, you should
-  first call get_crc_table() to initialize the tables before allowing more than
-  one thread to use crc32().
+  The crc tables are always the constant ones in crc32.h, so that nothing is
+  set up on the first call, and the first calls from several threads are
+  safe.  DYNAMIC_CRC_TABLE, which generated the tables at run time without any
+  protection against concurrent first use, is ignored.
 
-  DYNAMIC_CRC_TABLE and MAKECRCH can be #defined to write out crc32.h.
+  MAKECRCH can be #defined to generate the tables and write out crc32.h.
  */
 
 #ifdef MAKECRCH
@@ -26,6 +25,8 @@
 #  ifndef DYNAMIC_CRC_TABLE
 #    define DYNAMIC_CRC_TABLE
 #  endif /* !DYNAMIC_CRC_TABLE */
+#else
+#  undef DYNAMIC_CRC_TABLE
 #endif /* MAKECRCH */
 
 #include "zutil.h"      /* for STDC and FAR definitions */
@@ -44,6 +45,19 @@
 #  define TBLS 1
 #endif /* BYFOUR */
 
+/* Hardware-assisted CRC-32, selected at run time by z_cpu_features() */
+#ifdef Z_X86_SIMD
+#  define CRC32_PCLMUL
+   local z_crc_t crc32_pclmul OF((z_crc_t, const unsigned char FAR *,
+                                  z_size_t));
+#  define PCLMUL_MIN 64         /* shortest input worth folding */
+#endif
+#ifdef Z_ARM_SIMD
+#  define CRC32_ARMV8
+   local z_crc_t crc32_armv8 OF((z_crc_t, const unsigned char FAR *,
+                                 z_size_t));
+#endif
+
 /* Local functions for crc concatenation */
 local unsigned long gf2_matrix_times OF((unsigned long *mat,
                                          unsigned long vec));
@@ -144,7 +158,7 @@ local void make_crc_table()
         if (out == NULL) return;
         fprintf(out, "/* crc32.h -- tables for rapid CRC calculation\n");
         fprintf(out, " * Generated automatically by crc32.c\n */\n\n");
-        fprintf(out, "local const z_crc_t FAR ");
+        fprintf(out, "Z_ALIGNED(Z_CACHELINE) local const z_crc_t FAR ");
         fprintf(out, "crc_table[TBLS][256] =\n{\n  {\n");
         write_table(out, crc_table[0]);
 #  ifdef BYFOUR
@@ -211,6 +225,24 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
         make_crc_table();
 #endif /* DYNAMIC_CRC_TABLE */
 
+#ifdef CRC32_PCLMUL
+    if (len >= PCLMUL_MIN &&
+        (z_cpu_features() & (Z_CPU_PCLMUL | Z_CPU_SSE41)) ==
+            (Z_CPU_PCLMUL | Z_CPU_SSE41)) {
+        z_size_t n = len & ~(z_size_t)15;
+
+        crc = ~crc32_pclmul(~(z_crc_t)crc, buf, n) & 0xffffffffUL;
+        len -= n;
+        if (len == 0)
+            return crc;
+        buf += n;
+    }
+#endif /* CRC32_PCLMUL */
+#ifdef CRC32_ARMV8
+    if (z_cpu_features() & Z_CPU_ARMCRC)
+        return ~crc32_armv8(~(z_crc_t)crc, buf, len) & 0xffffffffUL;
+#endif /* CRC32_ARMV8 */
+
 #ifdef BYFOUR
     if (sizeof(void *) == sizeof(ptrdiff_t)) {
         z_crc_t endian;
@@ -338,6 +370,170 @@ local unsigned long crc32_big(crc, buf, len)
 
 #endif /* BYFOUR */
 
+#ifdef CRC32_PCLMUL
+
+/*
+   CRC-32 by folding with carry-less multiplication, as described in "Fast CRC
+   Computation for Generic Polynomials Using PCLMULQDQ Instruction" by Gopal,
+   Ozturk, Guilford, Wolrich, Feghali, Dixon and Karakoyunlu (Intel, 2009).
+   Four 128-bit lanes are folded forward 64 bytes at a time, then folded into
+   one lane, reduced to 64 bits and finally Barrett-reduced to the 32-bit CRC.
+   The constants are x^n mod p for the bit-reflected polynomial, as given at
+   the end of that paper.  c is the pre-conditioned (inverted) crc, and len
+   must be a multiple of 16 and at least PCLMUL_MIN.
+ */
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+Z_ALIGNED(16) local const z_u64 k1k2[2] =
+    { 0x0154442bd4ULL, 0x01c6e41596ULL };   /* x^(4*128+32), x^(4*128-32) */
+Z_ALIGNED(16) local const z_u64 k3k4[2] =
+    { 0x01751997d0ULL, 0x00ccaa009eULL };   /* x^(128+32), x^(128-32) */
+Z_ALIGNED(16) local const z_u64 k5k0[2] =
+    { 0x0163cd6124ULL, 0x0000000000ULL };   /* x^64 */
+Z_ALIGNED(16) local const z_u64 poly[2] =
+    { 0x01db710641ULL, 0x01f7011641ULL };   /* p, floor(x^64 / p) */
+
+/* ========================================================================= */
+Z_TARGET("sse4.1,pclmul")
+local z_crc_t crc32_pclmul(c, buf, len)
+    z_crc_t c;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)c));
+    x0 = _mm_load_si128((const __m128i *)k1k2);
+    buf += 64;
+    len -= 64;
+
+    /* fold four lanes in parallel */
+    while (len >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        y5 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+        buf += 64;
+        len -= 64;
+    }
+
+    /* fold the four lanes into one */
+    x0 = _mm_load_si128((const __m128i *)k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    /* fold in the remaining 16-byte blocks */
+    while (len >= 16) {
+        x2 = _mm_loadu_si128((const __m128i *)buf);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        buf += 16;
+        len -= 16;
+    }
+
+    /* reduce 128 bits to 64 */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits */
+    x0 = _mm_load_si128((const __m128i *)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (z_crc_t)_mm_extract_epi32(x1, 1);
+}
+
+#endif /* CRC32_PCLMUL */
+
+#ifdef CRC32_ARMV8
+
+/*
+   The ARMv8 CRC32 instructions implement exactly the zlib polynomial, eight
+   bytes per instruction.  c is the pre-conditioned (inverted) crc.
+ */
+#include <arm_acle.h>
+
+#ifdef __clang__
+#  define ARMCRC_TARGET "crc"
+#else
+#  define ARMCRC_TARGET "arch=armv8-a+crc"
+#endif
+
+/* ========================================================================= */
+Z_TARGET(ARMCRC_TARGET)
+local z_crc_t crc32_armv8(c, buf, len)
+    z_crc_t c;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    z_u64 word;
+
+    while (len && ((ptrdiff_t)buf & 7)) {
+        c = __crc32b(c, *buf++);
+        len--;
+    }
+    while (len >= 32) {
+        zmemcpy(&word, buf, 8);
+        c = __crc32d(c, word);
+        zmemcpy(&word, buf + 8, 8);
+        c = __crc32d(c, word);
+        zmemcpy(&word, buf + 16, 8);
+        c = __crc32d(c, word);
+        zmemcpy(&word, buf + 24, 8);
+        c = __crc32d(c, word);
+        buf += 32;
+        len -= 32;
+    }
+    while (len >= 8) {
+        zmemcpy(&word, buf, 8);
+        c = __crc32d(c, word);
+        buf += 8;
+        len -= 8;
+    }
+    while (len) {
+        c = __crc32b(c, *buf++);
+        len--;
+    }
+    return c;
+}
+
+#endif /* CRC32_ARMV8 */
+
 #define GF2_DIM 32      /* dimension of GF(2) vectors (length of CRC) */
 
 /* ========================================================================= */
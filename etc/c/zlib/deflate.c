@@ -51,6 +51,47 @@
 
 #include "deflate.h"
 
+/* FAST_MATCH replaces the rolling three-byte hash with a multiplicative hash
+   of four bytes, which has far fewer collisions, and compares candidate
+   matches many bytes at a time.  The output is a valid deflate stream, but is
+   not the same as without FAST_MATCH.  The assembler and FASTEST versions of
+   longest_match() depend on the rolling hash, so FAST_MATCH is ignored with
+   those. */
+#if defined(FAST_MATCH) && (defined(ASMV) || defined(FASTEST))
+#  undef FAST_MATCH
+#endif
+
+/* compare sixteen bytes at a time with SSE2, which every x86-64 processor has,
+   or else eight bytes at a time where a 64-bit count of trailing or leading
+   zeros is available (AArch64 has no byte mask instruction, so a word XOR is
+   as fast as a NEON compare there) */
+#ifdef FAST_MATCH
+#  if defined(__GNUC__) && defined(__SSE2__)
+#    include <emmintrin.h>
+#    define MATCH_SSE2
+#    define MATCH_CTZ(x) __builtin_ctz(x)
+#  elif defined(_MSC_VER) && !defined(__DMC__) && \
+        (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    include <intrin.h>
+#    define MATCH_SSE2
+       local unsigned match_ctz(unsigned long x) {
+           unsigned long n;
+           _BitScanForward(&n, x);
+           return (unsigned)n;
+       }
+#    define MATCH_CTZ(x) match_ctz(x)
+#  elif defined(__GNUC__) && defined(__SIZEOF_LONG_LONG__) && \
+        __SIZEOF_LONG_LONG__ == 8 && defined(__BYTE_ORDER__)
+#    define MATCH_WORD
+#    if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#      define MATCH_CTZ(x) __builtin_ctzll(x)
+#    else
+#      define MATCH_CTZ(x) __builtin_clzll(x)
+#    endif
+#  endif
+#endif
+
 const char deflate_copyright[] =
    " deflate 1.2.11 Copyright 1995-2017 Jean-loup Gailly and Mark Adler ";
 /*
@@ -75,15 +116,22 @@ typedef block_state (*compress_func) OF((deflate_state *s, int flush));
 
 local int deflateStateCheck      OF((z_streamp strm));
 local void slide_hash     OF((deflate_state *s));
+#ifndef MAXSEG_64K
+local void copy_state     OF((deflate_state *ds, deflate_state *ss));
+#endif
+local void slide_table    OF((Posf *table, unsigned n, unsigned wsize));
 local void fill_window    OF((deflate_state *s));
 local block_state deflate_stored OF((deflate_state *s, int flush));
 local block_state deflate_fast   OF((deflate_state *s, int flush));
 #ifndef FASTEST
 local block_state deflate_slow   OF((deflate_state *s, int flush));
+local block_state deflate_quick  OF((deflate_state *s, int flush));
 #endif
 local block_state deflate_rle    OF((deflate_state *s, int flush));
 local block_state deflate_huff   OF((deflate_state *s, int flush));
 local void lm_init        OF((deflate_state *s));
+local int  adapt          OF((deflate_state *s));
+local void end_passthrough OF((deflate_state *s));
 local void putShortMSB    OF((deflate_state *s, uInt b));
 local void flush_pending  OF((z_streamp strm));
 local unsigned read_buf   OF((z_streamp strm, Bytef *buf, unsigned size));
@@ -100,6 +148,21 @@ local  void check_match OF((deflate_state *s, IPos start, IPos match,
                             int length));
 #endif
 
+/* Vectorized slide_table(), selected at run time by z_cpu_features() */
+#ifdef Z_X86_SIMD
+#  define SLIDE_SSE2
+   local void slide_table_sse2 OF((Posf *table, unsigned n, unsigned wsize));
+#  if !defined(_MSC_VER) || _MSC_VER >= 1700
+#    define SLIDE_AVX2
+     local void slide_table_avx2 OF((Posf *table, unsigned n,
+                                     unsigned wsize));
+#  endif
+#endif
+#ifdef Z_ARM_SIMD
+#  define SLIDE_NEON
+   local void slide_table_neon OF((Posf *table, unsigned n, unsigned wsize));
+#endif
+
 /* ===========================================================================
  * Local data
  */
@@ -144,6 +207,17 @@ local const config configuration_table[10] = {
 /* 7 */ {8,   32, 128, 256, deflate_slow},
 /* 8 */ {32, 128, 258, 1024, deflate_slow},
 /* 9 */ {32, 258, 258, 4096, deflate_slow}}; /* max compression */
+
+/* Values for the strategies that choose their own parameters, Z_QUICK and
+ * Z_MEDIUM, at any level but 0.  For deflate_quick() lazy is the insert
+ * limit as for deflate_fast(), and a chain of one probes a single string.
+ * For Z_MEDIUM, deflate_slow() does not insert the strings of matches longer
+ * than lazy.
+ */
+local const config strategy_table[2] = {
+/*             good lazy nice chain */
+/* quick  */  {258,   4, 258,   1, deflate_quick},
+/* medium */  {8,    64, 128,  16, deflate_slow}};
 #endif
 
 /* Note: the deflate() code requires max_lazy >= MIN_MATCH and max_chain >= 4
@@ -151,6 +225,15 @@ local const config configuration_table[10] = {
  * meaning.
  */
 
+/* The parameters for a level and strategy */
+#ifdef FASTEST
+#  define CONFIG(level, strategy) (&configuration_table[level])
+#else
+#  define CONFIG(level, strategy) \
+    (((strategy) == Z_QUICK || (strategy) == Z_MEDIUM) && (level) != 0 ? \
+     &strategy_table[(strategy) - Z_QUICK] : &configuration_table[level])
+#endif
+
 /* rank Z_BLOCK between Z_NO_FLUSH and Z_PARTIAL_FLUSH */
 #define RANK(f) (((f) * 2) - ((f) > 4 ? 9 : 0))
 
@@ -162,6 +245,36 @@ local const config configuration_table[10] = {
  */
 #define UPDATE_HASH(s,h,c) (h = (((h)<<s->hash_shift) ^ (c)) & s->hash_mask)
 
+/* ===========================================================================
+ * Set ins_h to the hash of the string at window index str.  With FAST_MATCH
+ * the hash is the top hash_bits bits of the 32-bit product of the next four
+ * bytes with a Fibonacci constant, computed from scratch for each string, so
+ * it may read one byte past the lookahead (see WIN_PAD).  Otherwise the
+ * running hash is updated with the third byte of the string.
+ */
+#ifdef FAST_MATCH
+#  define HASH_STR(s, str) \
+   (s->ins_h = (uInt)(((((ulg)s->window[(str)] | \
+                         ((ulg)s->window[(str) + 1] << 8) | \
+                         ((ulg)s->window[(str) + 2] << 16) | \
+                         ((ulg)s->window[(str) + 3] << 24)) * 2654435761UL) & \
+                       0xffffffffUL) >> (32 - s->hash_bits)))
+#else
+#  define HASH_STR(s, str) \
+   UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)])
+#endif
+
+/* ===========================================================================
+ * Bytes allocated past each half of the window, so that FAST_MATCH can read
+ * whole words beyond the end of the window.  They are zeroed so that the
+ * output does not depend on uninitialized memory.
+ */
+#ifdef FAST_MATCH
+#  define WIN_PAD 8
+#else
+#  define WIN_PAD 0
+#endif
+
 
 /* ===========================================================================
  * Insert string str in the dictionary and set match_head to the previous head
@@ -175,12 +288,12 @@ local const config configuration_table[10] = {
  */
 #ifdef FASTEST
 #define INSERT_STRING(s, str, match_head) \
-   (UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)]), \
+   (HASH_STR(s, str), \
     match_head = s->head[s->ins_h], \
     s->head[s->ins_h] = (Pos)(str))
 #else
 #define INSERT_STRING(s, str, match_head) \
-   (UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)]), \
+   (HASH_STR(s, str), \
     match_head = s->prev[(str) & s->w_mask] = s->head[s->ins_h], \
     s->head[s->ins_h] = (Pos)(str))
 #endif
@@ -193,6 +306,13 @@ local const config configuration_table[10] = {
     s->head[s->hash_size-1] = NIL; \
     zmemzero((Bytef *)s->head, (unsigned)(s->hash_size-1)*sizeof(*s->head));
 
+/* ===========================================================================
+ * Rehashing the strings of the last stream to clear their buckets is done
+ * instead of clearing the whole hash table if there are no more of them than
+ * hash_size >> REHASH_SHIFT.
+ */
+#define REHASH_SHIFT 3
+
 /* ===========================================================================
  * Slide the hash table when sliding the window down (could be avoided with 32
  * bit values at the expense of memory usage). We slide even when level == 0 to
@@ -201,28 +321,117 @@ local const config configuration_table[10] = {
 local void slide_hash(s)
     deflate_state *s;
 {
-    unsigned n, m;
-    Posf *p;
     uInt wsize = s->w_size;
 
-    n = s->hash_size;
-    p = &s->head[n];
-    do {
-        m = *--p;
-        *p = (Pos)(m >= wsize ? m - wsize : NIL);
-    } while (--n);
-    n = wsize;
+    slide_table(s->head, s->hash_size, wsize);
 #ifndef FASTEST
-    p = &s->prev[n];
+    /* If n is not on any hash chain, prev[n] is garbage but its value will
+     * never be used.
+     */
+    slide_table(s->prev, wsize, wsize);
+#endif
+    s->slid = 1;
+    DSTAT(s, slides, 1);
+}
+
+/* ===========================================================================
+ * Subtract wsize from the n positions in table, replacing those that would
+ * fall out of the window with NIL.  Since NIL is zero, this is an unsigned
+ * saturating subtraction, which SIMD units do eight or sixteen at a time.
+ * n is a power of two that is at least 256, hash_size or w_size.
+ */
+local void slide_table(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    unsigned wsize;
+{
+    unsigned m;
+    Posf *p;
+
+    Assert(n >= 256 && (n & (n - 1)) == 0, "bad table size");
+#ifdef SLIDE_AVX2
+    if (z_cpu_features() & Z_CPU_AVX2) {
+        slide_table_avx2(table, n, wsize);
+        return;
+    }
+#endif
+#ifdef SLIDE_SSE2
+    if (z_cpu_features() & Z_CPU_SSE2) {
+        slide_table_sse2(table, n, wsize);
+        return;
+    }
+#endif
+#ifdef SLIDE_NEON
+    slide_table_neon(table, n, wsize);
+    return;
+#endif
+
+    p = &table[n];
     do {
         m = *--p;
         *p = (Pos)(m >= wsize ? m - wsize : NIL);
-        /* If n is not on any hash chain, prev[n] is garbage but
-         * its value will never be used.
-         */
     } while (--n);
+}
+
+#ifdef SLIDE_SSE2
+#  include <emmintrin.h>
+
+Z_TARGET("sse2")
+local void slide_table_sse2(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    unsigned wsize;
+{
+    __m128i w, *p;
+
+    w = _mm_set1_epi16((short)wsize);
+    p = (__m128i *)table;
+    do {
+        _mm_storeu_si128(p, _mm_subs_epu16(_mm_loadu_si128(p), w));
+        p++;
+    } while (n -= 8);
+}
+#endif
+
+#ifdef SLIDE_AVX2
+#  include <immintrin.h>
+
+Z_TARGET("avx2")
+local void slide_table_avx2(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    unsigned wsize;
+{
+    __m256i w, *p;
+
+    w = _mm256_set1_epi16((short)wsize);
+    p = (__m256i *)table;
+    do {
+        _mm256_storeu_si256(p, _mm256_subs_epu16(_mm256_loadu_si256(p), w));
+        p++;
+    } while (n -= 16);
+}
 #endif
+
+#ifdef SLIDE_NEON
+#  include <arm_neon.h>
+
+local void slide_table_neon(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    unsigned wsize;
+{
+    uint16x8_t w;
+    uint16_t *p;
+
+    w = vdupq_n_u16((uint16_t)wsize);
+    p = (uint16_t *)table;
+    do {
+        vst1q_u16(p, vqsubq_u16(vld1q_u16(p), w));
+        p += 8;
+    } while (n -= 8);
 }
+#endif
 
 /* ========================================================================= */
 int ZEXPORT deflateInit_(strm, level, version, stream_size)
@@ -297,7 +506,7 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
 #endif
     if (memLevel < 1 || memLevel > MAX_MEM_LEVEL || method != Z_DEFLATED ||
         windowBits < 8 || windowBits > 15 || level < 0 || level > 9 ||
-        strategy < 0 || strategy > Z_FIXED || (windowBits == 8 && wrap != 1)) {
+        strategy < 0 || strategy > Z_ADAPTIVE || (windowBits == 8 && wrap != 1)) {
         return Z_STREAM_ERROR;
     }
     if (windowBits == 8) windowBits = 9;  /* until 256-byte window bug fixed */
@@ -318,11 +527,13 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
     s->hash_mask = s->hash_size - 1;
     s->hash_shift =  ((s->hash_bits+MIN_MATCH-1)/MIN_MATCH);
 
-    s->window = (Bytef *) ZALLOC(strm, s->w_size, 2*sizeof(Byte));
+    s->window = (Bytef *) ZALLOC(strm, s->w_size + WIN_PAD, 2*sizeof(Byte));
     s->prev   = (Posf *)  ZALLOC(strm, s->w_size, sizeof(Pos));
     s->head   = (Posf *)  ZALLOC(strm, s->hash_size, sizeof(Pos));
 
     s->high_water = 0;      /* nothing written to s->window yet */
+    s->rehash = 0;          /* s->head is not initialized yet */
+    s->matches = 0;         /* no hash table slides pending for level 0 */
 
     s->lit_bufsize = 1 << (memLevel + 6); /* 16K elements by default */
 
@@ -337,6 +548,9 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
         deflateEnd (strm);
         return Z_MEM_ERROR;
     }
+#if WIN_PAD
+    zmemzero(s->window + 2*s->w_size, 2*WIN_PAD);
+#endif
     s->d_buf = overlay + s->lit_bufsize/sizeof(ush);
     s->l_buf = s->pending_buf + (1+sizeof(ush))*s->lit_bufsize;
 
@@ -418,7 +632,7 @@ int ZEXPORT deflateSetDictionary (strm, dictionary, dictLength)
         str = s->strstart;
         n = s->lookahead - (MIN_MATCH-1);
         do {
-            UPDATE_HASH(s, s->ins_h, s->window[str + MIN_MATCH-1]);
+            HASH_STR(s, str);
 #ifndef FASTEST
             s->prev[str & s->w_mask] = s->head[s->ins_h];
 #endif
@@ -463,6 +677,70 @@ int ZEXPORT deflateGetDictionary (strm, dictionary, dictLength)
     return Z_OK;
 }
 
+/* ========================================================================= */
+int ZEXPORT deflateCopyDictionary (dest, source)
+    z_streamp dest;
+    z_streamp source;
+{
+    deflate_state *ds, *ss;
+    uInt n;
+    int wrap;
+
+    if (deflateStateCheck(dest) || deflateStateCheck(source))
+        return Z_STREAM_ERROR;
+    ds = dest->state;
+    ss = source->state;
+    wrap = ds->wrap < 0 ? -ds->wrap : ds->wrap;   /* negative if finished */
+    if (wrap == 2 || (wrap && ss->wrap != wrap) ||
+        (ss->wrap == 1 && ss->status != INIT_STATE) ||
+        ss->lookahead || ss->pending || ss->last_flush != Z_NO_FLUSH ||
+        ss->block_start != (long)ss->strstart ||
+        ss->w_bits != ds->w_bits || ss->hash_bits != ds->hash_bits)
+        return Z_STREAM_ERROR;
+
+    /* start over as lm_init() would, but take the hash tables already built
+     * from the dictionary in source instead of clearing and rebuilding them
+     */
+    deflateResetKeep(dest);
+    ds->window_size = (ulg)2L*ds->w_size;
+    ds->max_lazy_match   = CONFIG(ds->level, ds->strategy)->max_lazy;
+    ds->good_match       = CONFIG(ds->level, ds->strategy)->good_length;
+    ds->nice_match       = CONFIG(ds->level, ds->strategy)->nice_length;
+    ds->max_chain_length = CONFIG(ds->level, ds->strategy)->max_chain;
+
+    n = ss->strstart;
+    zmemcpy(ds->window, ss->window, n);
+#ifndef FASTEST
+    zmemcpy((voidpf)ds->prev, (voidpf)ss->prev, n * sizeof(Pos));
+#endif
+    zmemcpy((voidpf)ds->head, (voidpf)ss->head, ds->hash_size * sizeof(Pos));
+    if (ds->high_water < n)
+        ds->high_water = n;
+
+    ds->strstart = n;
+    ds->block_start = ss->block_start;
+    ds->insert = ss->insert;
+    ds->ins_h = ss->ins_h;
+    ds->lookahead = 0;
+    ds->match_length = ds->prev_length = MIN_MATCH-1;
+    ds->match_available = 0;
+    ds->slid = ss->slid;
+#ifdef FAST_MATCH
+    ds->rehash = 0;         /* hashes may have read past the copied window */
+#else
+    ds->rehash = ss->rehash;
+#endif
+    dest->total_in = source->total_in;
+    if (ds->wrap)
+        dest->adler = source->adler;
+#ifndef FASTEST
+#ifdef ASMV
+    match_init();
+#endif
+#endif
+    return Z_OK;
+}
+
 /* ========================================================================= */
 int ZEXPORT deflateResetKeep (strm)
     z_streamp strm;
@@ -495,6 +773,10 @@ int ZEXPORT deflateResetKeep (strm)
 #endif
         adler32(0L, Z_NULL, 0);
     s->last_flush = Z_NO_FLUSH;
+    s->block_open = 0;
+#ifdef ZLIB_STATS
+    zmemzero(&s->stats, sizeof(s->stats));
+#endif
 
     _tr_init(s);
 
@@ -538,6 +820,20 @@ int ZEXPORT deflatePending (strm, pending, bits)
     return Z_OK;
 }
 
+/* ========================================================================= */
+int ZEXPORT deflateGetStats (strm, stats)
+    z_streamp strm;
+    z_deflate_stats *stats;
+{
+    if (deflateStateCheck(strm) || stats == Z_NULL) return Z_STREAM_ERROR;
+#ifdef ZLIB_STATS
+    *stats = strm->state->stats;
+    return Z_OK;
+#else
+    return Z_STREAM_ERROR;
+#endif
+}
+
 /* ========================================================================= */
 int ZEXPORT deflatePrime (strm, bits, value)
     z_streamp strm;
@@ -555,7 +851,7 @@ int ZEXPORT deflatePrime (strm, bits, value)
         put = Buf_size - s->bi_valid;
         if (put > bits)
             put = bits;
-        s->bi_buf |= (ush)((value & ((1 << put) - 1)) << s->bi_valid);
+        s->bi_buf |= (bi_t)(value & ((1 << put) - 1)) << s->bi_valid;
         s->bi_valid += put;
         _tr_flush_bits(s);
         value >>= put;
@@ -571,7 +867,7 @@ int ZEXPORT deflateParams(strm, level, strategy)
     int strategy;
 {
     deflate_state *s;
-    compress_func func;
+    const config *cfg;
 
     if (deflateStateCheck(strm)) return Z_STREAM_ERROR;
     s = strm->state;
@@ -581,12 +877,13 @@ int ZEXPORT deflateParams(strm, level, strategy)
 #else
     if (level == Z_DEFAULT_COMPRESSION) level = 6;
 #endif
-    if (level < 0 || level > 9 || strategy < 0 || strategy > Z_FIXED) {
+    if (level < 0 || level > 9 || strategy < 0 || strategy > Z_ADAPTIVE) {
         return Z_STREAM_ERROR;
     }
-    func = configuration_table[s->level].func;
+    cfg = CONFIG(level, strategy);
 
-    if ((strategy != s->strategy || func != configuration_table[level].func) &&
+    if ((strategy != s->strategy ||
+         CONFIG(s->level, s->strategy)->func != cfg->func) &&
         s->high_water) {
         /* Flush the last buffer: */
         int err = deflate(strm, Z_BLOCK);
@@ -594,8 +891,19 @@ int ZEXPORT deflateParams(strm, level, strategy)
             return err;
         if (strm->avail_out == 0)
             return Z_BUF_ERROR;
+        /* The compress functions leave match_length and prev_length in
+         * different states, possibly zero, which longest_match() does not
+         * allow for.  Start the next one as lm_init() does.
+         */
+        s->match_length = s->prev_length = MIN_MATCH-1;
+    }
+    if (s->passthrough == 2 && (strategy != Z_ADAPTIVE || level == 0)) {
+        if (level == 0)
+            s->passthrough = 0; /* deflate_stored() goes on, with s->matches */
+        else
+            end_passthrough(s);
     }
-    if (s->level != level) {
+    if (s->level != level || CONFIG(s->level, s->strategy) != cfg) {
         if (s->level == 0 && s->matches != 0) {
             if (s->matches == 1)
                 slide_hash(s);
@@ -603,11 +911,15 @@ int ZEXPORT deflateParams(strm, level, strategy)
                 CLEAR_HASH(s);
             s->matches = 0;
         }
+#ifdef FAST_MATCH
+        if (level == 0)
+            s->rehash = 0;  /* deflate_stored() reads in without fill_window() */
+#endif
         s->level = level;
-        s->max_lazy_match   = configuration_table[level].max_lazy;
-        s->good_match       = configuration_table[level].good_length;
-        s->nice_match       = configuration_table[level].nice_length;
-        s->max_chain_length = configuration_table[level].max_chain;
+        s->max_lazy_match   = cfg->max_lazy;
+        s->good_match       = cfg->good_length;
+        s->nice_match       = cfg->nice_length;
+        s->max_chain_length = cfg->max_chain;
     }
     s->strategy = strategy;
     return Z_OK;
@@ -699,8 +1011,10 @@ uLong ZEXPORT deflateBound(strm, sourceLen)
         wraplen = 6;
     }
 
-    /* if not default parameters, return conservative bound */
-    if (s->w_bits != 15 || s->hash_bits != 8 + 7)
+    /* if not default parameters, or if fixed codes are used without a
+       stored fallback, return conservative bound */
+    if (s->w_bits != 15 || s->hash_bits != 8 + 7 ||
+        (s->strategy == Z_QUICK && s->level != 0))
         return complen + wraplen;
 
     /* default settings: return tight bound for that case */
@@ -997,10 +1311,21 @@ int ZEXPORT deflate (strm, flush)
         (flush != Z_NO_FLUSH && s->status != FINISH_STATE)) {
         block_state bstate;
 
-        bstate = s->level == 0 ? deflate_stored(s, flush) :
-                 s->strategy == Z_HUFFMAN_ONLY ? deflate_huff(s, flush) :
-                 s->strategy == Z_RLE ? deflate_rle(s, flush) :
-                 (*(configuration_table[s->level].func))(s, flush);
+        /* For Z_ADAPTIVE, go on with the input where the compress function
+         * left off when it switches between compressing and storing. With
+         * no room left for output, that waits for the next call, as
+         * deflate_stored() must start with nothing pending.
+         */
+        adapt(s);
+        for (;;) {
+            bstate = s->level == 0 || s->passthrough == 2 ?
+                         deflate_stored(s, flush) :
+                     s->strategy == Z_HUFFMAN_ONLY ? deflate_huff(s, flush) :
+                     s->strategy == Z_RLE ? deflate_rle(s, flush) :
+                     (*(CONFIG(s->level, s->strategy)->func))(s, flush);
+            if (bstate != need_more || strm->avail_out == 0 || !adapt(s))
+                break;
+        }
 
         if (bstate == finish_started || bstate == finish_done) {
             s->status = FINISH_STATE;
@@ -1125,7 +1450,7 @@ int ZEXPORT deflateCopy (dest, source)
     zmemcpy((voidpf)ds, (voidpf)ss, sizeof(deflate_state));
     ds->strm = dest;
 
-    ds->window = (Bytef *) ZALLOC(dest, ds->w_size, 2*sizeof(Byte));
+    ds->window = (Bytef *) ZALLOC(dest, ds->w_size + WIN_PAD, 2*sizeof(Byte));
     ds->prev   = (Posf *)  ZALLOC(dest, ds->w_size, sizeof(Pos));
     ds->head   = (Posf *)  ZALLOC(dest, ds->hash_size, sizeof(Pos));
     overlay = (ushf *) ZALLOC(dest, ds->lit_bufsize, sizeof(ush)+2);
@@ -1136,23 +1461,99 @@ int ZEXPORT deflateCopy (dest, source)
         deflateEnd (dest);
         return Z_MEM_ERROR;
     }
+#if WIN_PAD
+    zmemzero(ds->window + 2*ds->w_size, 2*WIN_PAD);
+#endif
+    copy_state(ds, ss);
+    return Z_OK;
+#endif /* MAXSEG_64K */
+}
+
+/* ========================================================================= */
+int ZEXPORT deflateFork (dest, source)
+    z_streamp dest;
+    z_streamp source;
+{
+#ifdef MAXSEG_64K
+    return Z_STREAM_ERROR;
+#else
+    deflate_state *ds;
+    deflate_state *ss;
+
+    if (deflateStateCheck(dest) || deflateStateCheck(source))
+        return Z_STREAM_ERROR;
+    ds = dest->state;
+    ss = source->state;
+    if (ds == ss || ds->w_bits != ss->w_bits ||
+        ds->hash_bits != ss->hash_bits || ds->lit_bufsize != ss->lit_bufsize)
+        return Z_STREAM_ERROR;
+
+    dest->next_in = source->next_in;
+    dest->avail_in = source->avail_in;
+    dest->total_in = source->total_in;
+    dest->next_out = source->next_out;
+    dest->avail_out = source->avail_out;
+    dest->total_out = source->total_out;
+    dest->data_type = source->data_type;
+    dest->adler = source->adler;
+    copy_state(ds, ss);
+    return Z_OK;
+#endif /* MAXSEG_64K */
+}
+
+#ifndef MAXSEG_64K
+/* ===========================================================================
+ * Make ds a copy of ss, keeping the buffers of ds, which are the same sizes.
+ * Only what is in use is copied: the window up to the high water mark, the
+ * hash chains of the strings inserted so far, and the pending output and
+ * symbols.  Early in a stream that is far less than the whole of them.
+ */
+local void copy_state(ds, ss)
+    deflate_state *ds;
+    deflate_state *ss;
+{
+    z_streamp strm = ds->strm;
+    Bytef *window = ds->window;
+    Posf *prev = ds->prev;
+    Posf *head = ds->head;
+    Bytef *pending_buf = ds->pending_buf;
+    ulg used;
+
+    zmemcpy((voidpf)ds, (voidpf)ss, sizeof(deflate_state));
+    ds->strm = strm;
+    ds->window = window;
+    ds->prev = prev;
+    ds->head = head;
+    ds->pending_buf = pending_buf;
+
     /* following zmemcpy do not work for 16-bit MSDOS */
-    zmemcpy(ds->window, ss->window, ds->w_size * 2 * sizeof(Byte));
-    zmemcpy((voidpf)ds->prev, (voidpf)ss->prev, ds->w_size * sizeof(Pos));
+    used = ss->strstart + ss->lookahead;
+    if (used < ss->high_water)
+        used = ss->high_water;
+    if (used > ss->window_size)
+        used = ss->window_size;
+    zmemcpy(ds->window, ss->window, (unsigned)used);
+#ifndef FASTEST
+    used = ss->strstart + ss->lookahead;
+    if (ss->slid || ss->matches || used > ss->w_size)
+        used = ss->w_size;          /* slid, or a slide pending if stored */
+    zmemcpy((voidpf)ds->prev, (voidpf)ss->prev, (unsigned)used * sizeof(Pos));
+#endif
     zmemcpy((voidpf)ds->head, (voidpf)ss->head, ds->hash_size * sizeof(Pos));
-    zmemcpy(ds->pending_buf, ss->pending_buf, (uInt)ds->pending_buf_size);
 
     ds->pending_out = ds->pending_buf + (ss->pending_out - ss->pending_buf);
-    ds->d_buf = overlay + ds->lit_bufsize/sizeof(ush);
+    ds->d_buf = (ushf *)ds->pending_buf + ds->lit_bufsize/sizeof(ush);
     ds->l_buf = ds->pending_buf + (1+sizeof(ush))*ds->lit_bufsize;
+    zmemcpy(ds->pending_buf, ss->pending_buf,
+            (unsigned)(ss->pending_out - ss->pending_buf) + ss->pending);
+    zmemcpy((voidpf)ds->d_buf, (voidpf)ss->d_buf, ss->last_lit * sizeof(ush));
+    zmemcpy(ds->l_buf, ss->l_buf, ss->last_lit);
 
     ds->l_desc.dyn_tree = ds->dyn_ltree;
     ds->d_desc.dyn_tree = ds->dyn_dtree;
     ds->bl_desc.dyn_tree = ds->bl_tree;
-
-    return Z_OK;
-#endif /* MAXSEG_64K */
 }
+#endif /* !MAXSEG_64K */
 
 /* ===========================================================================
  * Read a new buffer from the current input stream, update the adler32
@@ -1188,6 +1589,39 @@ local unsigned read_buf(strm, buf, size)
     return len;
 }
 
+/* ===========================================================================
+ * Clear the hash table for a new stream.  After a short stream, such as one
+ * of many small messages compressed with the same state, the buckets of its
+ * strings are found by hashing them again and only those are cleared, which
+ * is much less work than clearing the whole table.  That needs the window to
+ * be as it was when they were inserted, so not after it has slid or been
+ * moved for stored blocks.
+ */
+local void clear_hash(s)
+    deflate_state *s;
+{
+    ulg used = (ulg)s->strstart + s->lookahead;
+    uInt str;
+
+    if (!s->rehash || s->slid || s->matches ||
+        used > (ulg)(s->hash_size >> REHASH_SHIFT)) {
+        CLEAR_HASH(s);
+        s->rehash = 1;
+        return;
+    }
+    if (used < MIN_MATCH)
+        return;
+    s->ins_h = s->window[0];
+    UPDATE_HASH(s, s->ins_h, s->window[1]);
+#if MIN_MATCH != 3
+    Call UPDATE_HASH() MIN_MATCH-3 more times
+#endif
+    for (str = 0; str <= (uInt)used - MIN_MATCH; str++) {
+        HASH_STR(s, str);
+        s->head[s->ins_h] = NIL;
+    }
+}
+
 /* ===========================================================================
  * Initialize the "longest match" routines for a new zlib stream
  */
@@ -1196,14 +1630,16 @@ local void lm_init (s)
 {
     s->window_size = (ulg)2L*s->w_size;
 
-    CLEAR_HASH(s);
+    clear_hash(s);
+    s->matches = 0;         /* no slides are pending on a cleared table */
+    s->passthrough = 0;
 
     /* Set the default configuration parameters:
      */
-    s->max_lazy_match   = configuration_table[s->level].max_lazy;
-    s->good_match       = configuration_table[s->level].good_length;
-    s->nice_match       = configuration_table[s->level].nice_length;
-    s->max_chain_length = configuration_table[s->level].max_chain;
+    s->max_lazy_match   = CONFIG(s->level, s->strategy)->max_lazy;
+    s->good_match       = CONFIG(s->level, s->strategy)->good_length;
+    s->nice_match       = CONFIG(s->level, s->strategy)->nice_length;
+    s->max_chain_length = CONFIG(s->level, s->strategy)->max_chain;
 
     s->strstart = 0;
     s->block_start = 0L;
@@ -1212,6 +1648,7 @@ local void lm_init (s)
     s->match_length = s->prev_length = MIN_MATCH-1;
     s->match_available = 0;
     s->ins_h = 0;
+    s->slid = 0;
 #ifndef FASTEST
 #ifdef ASMV
     match_init(); /* initialize the asm code */
@@ -1229,7 +1666,112 @@ local void lm_init (s)
  *   string (strstart) and its distance is <= MAX_DIST, and prev_length >= 1
  * OUT assertion: the match length is not greater than s->lookahead.
  */
-#ifndef ASMV
+#ifdef FAST_MATCH
+/* ---------------------------------------------------------------------------
+ * Return the number of equal leading bytes at scan and match, up to MAX_MATCH.
+ * This reads up to 2*WIN_PAD - 2 bytes past scan + MAX_MATCH, which the window
+ * padding allows for since strstart <= window_size - MIN_LOOKAHEAD.
+ */
+local unsigned compare258(scan, match)
+    Bytef *scan;
+    Bytef *match;
+{
+    unsigned len = 0;
+#if defined(MATCH_SSE2)
+    int diff;
+
+    do {
+        diff = _mm_movemask_epi8(_mm_cmpeq_epi8(
+                   _mm_loadu_si128((__m128i *)(scan + len)),
+                   _mm_loadu_si128((__m128i *)(match + len)))) ^ 0xffff;
+        if (diff) {
+            len += (unsigned)MATCH_CTZ(diff);
+            return len < MAX_MATCH ? len : MAX_MATCH;
+        }
+        len += 16;
+    } while (len < MAX_MATCH);
+    return MAX_MATCH;
+#elif defined(MATCH_WORD)
+    unsigned long long a, b;
+
+    do {
+        zmemcpy(&a, scan + len, sizeof(a));
+        zmemcpy(&b, match + len, sizeof(b));
+        if (a != b) {
+            len += (unsigned)MATCH_CTZ(a ^ b) >> 3;
+            return len < MAX_MATCH ? len : MAX_MATCH;
+        }
+        len += 8;
+    } while (len < MAX_MATCH);
+    return MAX_MATCH;
+#else
+    while (len < MAX_MATCH && scan[len] == match[len])
+        len++;
+    return len;
+#endif
+}
+
+/* ---------------------------------------------------------------------------
+ * Version for FAST_MATCH.  Since the hash covers four bytes, equal hashes do
+ * not imply any equal bytes, so each candidate is compared in full.
+ */
+local uInt longest_match(s, cur_match)
+    deflate_state *s;
+    IPos cur_match;                             /* current match */
+{
+    unsigned chain_length = s->max_chain_length;/* max hash chain length */
+    Bytef *scan = s->window + s->strstart;      /* current string */
+    Bytef *match;                               /* matched string */
+    unsigned len;                               /* length of current match */
+    unsigned best_len = s->prev_length;         /* best match length so far */
+    unsigned nice_match = (unsigned)s->nice_match; /* stop if long enough */
+    IPos limit = s->strstart > (IPos)MAX_DIST(s) ?
+        s->strstart - (IPos)MAX_DIST(s) : NIL;
+    Posf *prev = s->prev;
+    uInt wmask = s->w_mask;
+    Byte scan_end1 = scan[best_len-1];
+    Byte scan_end = scan[best_len];
+
+    /* Do not waste too much time if we already have a good match: */
+    if (s->prev_length >= s->good_match) {
+        chain_length >>= 2;
+    }
+    /* Do not look for matches beyond the end of the input. This is necessary
+     * to make deflate deterministic.
+     */
+    if (nice_match > s->lookahead) nice_match = s->lookahead;
+
+    Assert((ulg)s->strstart <= s->window_size-MIN_LOOKAHEAD, "need lookahead");
+    DSTAT(s, match_calls, 1);
+
+    do {
+        DSTAT(s, chain_steps, 1);
+        Assert(cur_match < s->strstart, "no future");
+        match = s->window + cur_match;
+
+        /* Skip to the next match if this one cannot be longer than the best
+         * one so far, or does not even start with the same byte.
+         */
+        if (match[best_len]   != scan_end  ||
+            match[best_len-1] != scan_end1 ||
+            *match            != *scan)        continue;
+
+        len = compare258(scan, match);
+        if (len > best_len) {
+            s->match_start = cur_match;
+            best_len = len;
+            if (len >= nice_match) break;
+            scan_end1  = scan[best_len-1];
+            scan_end   = scan[best_len];
+        }
+    } while ((cur_match = prev[cur_match & wmask]) > limit
+             && --chain_length != 0);
+
+    if ((uInt)best_len <= s->lookahead) return (uInt)best_len;
+    return s->lookahead;
+}
+
+#elif !defined(ASMV)
 /* For 80x86 and 680x0, an optimized version will be provided in match.asm or
  * match.S. The code will be functionally equivalent.
  */
@@ -1279,8 +1821,10 @@ local uInt longest_match(s, cur_match)
     if ((uInt)nice_match > s->lookahead) nice_match = (int)s->lookahead;
 
     Assert((ulg)s->strstart <= s->window_size-MIN_LOOKAHEAD, "need lookahead");
+    DSTAT(s, match_calls, 1);
 
     do {
+        DSTAT(s, chain_steps, 1);
         Assert(cur_match < s->strstart, "no future");
         match = s->window + cur_match;
 
@@ -1375,7 +1919,7 @@ local uInt longest_match(s, cur_match)
     if ((uInt)best_len <= s->lookahead) return (uInt)best_len;
     return s->lookahead;
 }
-#endif /* ASMV */
+#endif /* FAST_MATCH, ASMV */
 
 #else /* FASTEST */
 
@@ -1397,6 +1941,8 @@ local uInt longest_match(s, cur_match)
     Assert(s->hash_bits >= 8 && MAX_MATCH == 258, "Code too clever");
 
     Assert((ulg)s->strstart <= s->window_size-MIN_LOOKAHEAD, "need lookahead");
+    DSTAT(s, match_calls, 1);
+    DSTAT(s, chain_steps, 1);
 
     Assert(cur_match < s->strstart, "no future");
 
@@ -1508,7 +2054,10 @@ local void fill_window(s)
          * move the upper half to the lower one to make room in the upper half.
          */
         if (s->strstart >= wsize+MAX_DIST(s)) {
-
+            /* The halves do not overlap, and both start on a multiple of
+             * wsize, so this is an aligned copy that the library memcpy()
+             * does at full width.  Only the bytes still in use are copied.
+             */
             zmemcpy(s->window, s->window+wsize, (unsigned)wsize - more);
             s->match_start -= wsize;
             s->strstart    -= wsize; /* we now have strstart >= MAX_DIST */
@@ -1531,6 +2080,13 @@ local void fill_window(s)
          */
         Assert(more >= 2, "more < 2");
 
+#ifdef FAST_MATCH
+        /* a string at the end of the data may have been hashed with the byte
+         * about to be read over, so its bucket could not be found again
+         */
+        if (s->strstart + s->lookahead)
+            s->rehash = 0;
+#endif
         n = read_buf(s->strm, s->window + s->strstart + s->lookahead, more);
         s->lookahead += n;
 
@@ -1543,7 +2099,7 @@ local void fill_window(s)
             Call UPDATE_HASH() MIN_MATCH-3 more times
 #endif
             while (s->insert) {
-                UPDATE_HASH(s, s->ins_h, s->window[str + MIN_MATCH-1]);
+                HASH_STR(s, str);
 #ifndef FASTEST
                 s->prev[str & s->w_mask] = s->head[s->ins_h];
 #endif
@@ -1613,10 +2169,13 @@ local void fill_window(s)
    Tracev((stderr,"[FLUSH]")); \
 }
 
-/* Same but force premature exit if necessary. */
+/* Same but force premature exit if necessary, or to let deflate() switch to
+ * storing for Z_ADAPTIVE.
+ */
 #define FLUSH_BLOCK(s, last) { \
    FLUSH_BLOCK_ONLY(s, last); \
-   if (s->strm->avail_out == 0) return (last) ? finish_started : need_more; \
+   if (s->strm->avail_out == 0 || s->passthrough) \
+       return (last) ? finish_started : need_more; \
 }
 
 /* Maximum stored block length in deflate format (not including header). */
@@ -1625,6 +2184,87 @@ local void fill_window(s)
 /* Minimum of a and b. */
 #define MIN(a, b) ((a) > (b) ? (b) : (a))
 
+/* True when Z_ADAPTIVE has stored enough to try compressing again. */
+#define PROBE_DUE(s) ((s)->passthrough == 2 && (s)->passed >= PASSTHROUGH_PROBE)
+
+/* ===========================================================================
+ * For Z_ADAPTIVE, switch to storing when _tr_flush_block() has found the last
+ * block incompressible, or back to compressing when PASSTHROUGH_PROBE bytes
+ * have been stored. Return true if the function that returned early for this
+ * must be followed by another call, to the other function if it switched.
+ * Either switch is made only between blocks.
+ */
+local int adapt(s)
+    deflate_state *s;
+{
+    if (s->passthrough == 1) {
+        /* deflate_stored() needs a free byte at the end of the window. If
+         * the lookahead fills it and it can not slide, keep compressing.
+         */
+        if ((ulg)s->strstart + s->lookahead >= s->window_size &&
+            s->block_start < (long)s->w_size) {
+            s->passthrough = 0;
+            return 1;
+        }
+
+        /* A literal that deflate_slow() has not sent yet is the first byte
+         * after the block. It and the lookahead are left in the window for
+         * deflate_stored(), which writes them first.
+         */
+        if (s->match_available) {
+            s->match_available = 0;
+            s->strstart--;
+            s->lookahead++;
+        }
+        Assert(s->block_start == (long)s->strstart, "block not flushed");
+        s->strstart += s->lookahead;
+        s->lookahead = 0;
+        if (s->strstart >= s->window_size) {
+            /* Slide the window down, as deflate_stored() does. */
+            s->block_start -= s->w_size;
+            s->strstart -= s->w_size;
+            zmemcpy(s->window, s->window + s->w_size, s->strstart);
+            if (s->matches < 2)
+                s->matches++;           /* add a pending slide_hash() */
+        }
+        s->passthrough = 2;
+        s->passed = 0;
+#ifdef FAST_MATCH
+        s->rehash = 0;  /* deflate_stored() reads in without fill_window() */
+#endif
+        return 1;
+    }
+    if (PROBE_DUE(s)) {
+        end_passthrough(s);
+        return 1;
+    }
+    return 0;
+}
+
+/* ===========================================================================
+ * Stop storing for Z_ADAPTIVE. The hash table is brought up to date as
+ * deflateParams() does when leaving level 0, and what deflate_stored() has
+ * read into the window but not written becomes lookahead again.
+ */
+local void end_passthrough(s)
+    deflate_state *s;
+{
+    if (s->matches != 0) {
+        if (s->matches == 1)
+            slide_hash(s);
+        else
+            CLEAR_HASH(s);
+        s->matches = 0;
+    }
+    s->lookahead = s->strstart - (uInt)s->block_start;
+    s->strstart = (uInt)s->block_start;
+    if (s->insert > s->strstart)
+        s->insert = s->strstart;
+    s->match_length = s->prev_length = MIN_MATCH-1;
+    s->match_available = 0;
+    s->passthrough = 0;
+}
+
 /* ===========================================================================
  * Copy without compression as much as possible from the input stream, return
  * the current block state.
@@ -1697,6 +2337,7 @@ local block_state deflate_stored(s, flush)
 
         /* Write the stored block header bytes. */
         flush_pending(s->strm);
+        s->passed += len;
 
 #ifdef ZLIB_DEBUG
         /* Update debugging counts for the data about to be copied. */
@@ -1725,7 +2366,7 @@ local block_state deflate_stored(s, flush)
             s->strm->avail_out -= len;
             s->strm->total_out += len;
         }
-    } while (last == 0);
+    } while (last == 0 && !PROBE_DUE(s));
 
     /* Update the sliding window with the last s->w_size bytes of the copied
      * data, or append all of the copied data to the existing window if less
@@ -1764,6 +2405,10 @@ local block_state deflate_stored(s, flush)
     if (last)
         return finish_done;
 
+    /* For Z_ADAPTIVE, have deflate() try compressing again. */
+    if (PROBE_DUE(s))
+        return need_more;
+
     /* If flushing and all input has been consumed, then done. */
     if (flush != Z_NO_FLUSH && flush != Z_FINISH &&
         s->strm->avail_in == 0 && (long)s->strstart == s->block_start)
@@ -1807,6 +2452,7 @@ local block_state deflate_stored(s, flush)
                len == left ? 1 : 0;
         _tr_stored_block(s, (charf *)s->window + s->block_start, len, last);
         s->block_start += len;
+        s->passed += len;
         flush_pending(s->strm);
     }
 
@@ -1998,15 +2644,28 @@ local block_state deflate_slow(s, flush)
              * the hash table.
              */
             s->lookahead -= s->prev_length-1;
-            s->prev_length -= 2;
-            do {
-                if (++s->strstart <= max_insert) {
-                    INSERT_STRING(s, s->strstart, hash_head);
-                }
-            } while (--s->prev_length != 0);
+            if (s->strategy == Z_MEDIUM &&
+                s->prev_length > s->max_lazy_match) {
+                /* As in deflate_fast(), skip the strings of a long match
+                 * and restart the hash after it.
+                 */
+                s->strstart += s->prev_length-1;
+                s->ins_h = s->window[s->strstart];
+                UPDATE_HASH(s, s->ins_h, s->window[s->strstart+1]);
+#if MIN_MATCH != 3
+                Call UPDATE_HASH() MIN_MATCH-3 more times
+#endif
+            } else {
+                s->prev_length -= 2;
+                do {
+                    if (++s->strstart <= max_insert) {
+                        INSERT_STRING(s, s->strstart, hash_head);
+                    }
+                } while (--s->prev_length != 0);
+                s->strstart++;
+            }
             s->match_available = 0;
             s->match_length = MIN_MATCH-1;
-            s->strstart++;
 
             if (bflush) FLUSH_BLOCK(s, 0);
 
@@ -2022,7 +2681,7 @@ local block_state deflate_slow(s, flush)
             }
             s->strstart++;
             s->lookahead--;
-            if (s->strm->avail_out == 0) return need_more;
+            if (s->strm->avail_out == 0 || s->passthrough) return need_more;
         } else {
             /* There is no previous match to compare with, wait for
              * the next step to decide.
@@ -2047,6 +2706,119 @@ local block_state deflate_slow(s, flush)
         FLUSH_BLOCK(s, 0);
     return block_done;
 }
+
+/* ===========================================================================
+ * For Z_QUICK, look at one candidate per string only and take every match at
+ * once.  The symbols are sent with the fixed codes as they are found, so
+ * there is no symbol buffer, no second pass over it, and no trees.  A block
+ * stays open across calls until a flush is requested.  Since it can not fall
+ * back to a stored block, incompressible data grows by one eighth, which
+ * deflateBound() allows for.
+ */
+#define QUICK_START_BLOCK(s, last) { \
+    _tr_fixed_start(s, last); \
+    s->block_open = 1 + (last); \
+    s->block_start = s->strstart; \
+}
+
+#define QUICK_END_BLOCK(s, last) { \
+    if (s->block_open) { \
+        _tr_fixed_end(s, last); \
+        s->block_open = 0; \
+        s->block_start = s->strstart; \
+        flush_pending(s->strm); \
+        if (s->strm->avail_out == 0) \
+            return (last) ? finish_started : need_more; \
+    } \
+}
+
+local block_state deflate_quick(s, flush)
+    deflate_state *s;
+    int flush;
+{
+    IPos hash_head;       /* head of the hash chain */
+    int last;             /* true if this is the last block */
+
+    last = flush == Z_FINISH;
+    if (last && s->block_open != 2) {
+        QUICK_END_BLOCK(s, 0);
+        QUICK_START_BLOCK(s, 1);
+    }
+
+    for (;;) {
+        /* Leave room for a symbol and the bit buffer */
+        if (s->pending + 8 >= s->pending_buf_size) {
+            flush_pending(s->strm);
+            if (s->strm->avail_out == 0)
+                return need_more;
+        }
+
+        /* Make sure that we always have enough lookahead, except
+         * at the end of the input file.
+         */
+        if (s->lookahead < MIN_LOOKAHEAD) {
+            fill_window(s);
+            if (s->lookahead < MIN_LOOKAHEAD && flush == Z_NO_FLUSH) {
+                return need_more;
+            }
+            if (s->lookahead == 0) break; /* end the current block */
+        }
+
+        /* Start a block only when there is data for it, so that a flush
+         * without new input does not write an empty block.
+         */
+        if (s->block_open == 0)
+            QUICK_START_BLOCK(s, 0);
+
+        hash_head = NIL;
+        if (s->lookahead >= MIN_MATCH) {
+            INSERT_STRING(s, s->strstart, hash_head);
+        }
+        if (hash_head != NIL && s->strstart - hash_head <= MAX_DIST(s)) {
+            s->match_length = longest_match (s, hash_head);
+            /* longest_match() sets match_start */
+        }
+        if (s->match_length >= MIN_MATCH) {
+            check_match(s, s->strstart, s->match_start, s->match_length);
+
+            _tr_fixed_dist(s, s->strstart - s->match_start,
+                           s->match_length - MIN_MATCH);
+
+            s->lookahead -= s->match_length;
+
+            /* As in deflate_fast(), insert the strings of short matches */
+            if (s->match_length <= s->max_insert_length &&
+                s->lookahead >= MIN_MATCH) {
+                s->match_length--; /* string at strstart already in table */
+                do {
+                    s->strstart++;
+                    INSERT_STRING(s, s->strstart, hash_head);
+                } while (--s->match_length != 0);
+                s->strstart++;
+            } else {
+                s->strstart += s->match_length;
+                s->match_length = 0;
+                s->ins_h = s->window[s->strstart];
+                UPDATE_HASH(s, s->ins_h, s->window[s->strstart+1]);
+#if MIN_MATCH != 3
+                Call UPDATE_HASH() MIN_MATCH-3 more times
+#endif
+            }
+        } else {
+            /* No match, output a literal byte */
+            _tr_fixed_lit(s, s->window[s->strstart]);
+            s->lookahead--;
+            s->strstart++;
+        }
+    }
+    s->insert = s->strstart < MIN_MATCH-1 ? s->strstart : MIN_MATCH-1;
+    if (last) {
+        QUICK_END_BLOCK(s, 1);
+        return finish_done;
+    }
+    QUICK_END_BLOCK(s, 0);
+    return block_done;
+}
 #endif /* FASTEST */
 
 /* ===========================================================================
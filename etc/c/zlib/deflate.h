@@ -48,8 +48,24 @@
 #define MAX_BITS 15
 /* All codes must not exceed MAX_BITS bits */
 
-#define Buf_size 16
-/* size of bit buffer in bi_buf */
+/* DEFLATE_BITS64 selects a 64-bit bit buffer, which the emitter fills with a
+   whole match at a time and empties eight bytes at a time.  It is meant for
+   64-bit processors, and is ignored otherwise. */
+#if defined(DEFLATE_BITS64) && \
+    !(defined(__x86_64__) || defined(_M_X64) || defined(_M_ARM64) || \
+      (defined(__GNUC__) && defined(__SIZEOF_POINTER__) && \
+       __SIZEOF_POINTER__ == 8))
+#  undef DEFLATE_BITS64
+#endif
+
+#ifdef DEFLATE_BITS64
+   typedef unsigned long long bi_t;
+#  define Buf_size 64
+#else
+   typedef ush bi_t;
+#  define Buf_size 16
+#endif
+/* type and size of bit buffer in bi_buf */
 
 #define INIT_STATE    42    /* zlib header -> BUSY_STATE */
 #ifdef GZIP
@@ -257,13 +273,18 @@ typedef struct internal_state {
     ulg bits_sent;      /* bit length of compressed data sent mod 2^32 */
 #endif
 
-    ush bi_buf;
+    bi_t bi_buf;
     /* Output buffer. bits are inserted starting at the bottom (least
      * significant bits).
      */
     int bi_valid;
-    /* Number of valid bits in bi_buf.  All bits above the last valid bit
-     * are always zero.
+    /* Number of valid bits in bi_buf, less than Buf_size.  All bits above
+     * the last valid bit are always zero.
+     */
+
+    int block_open;
+    /* Whether deflate_quick() has a fixed code block open: 0 if not, 1 if
+     * so, 2 if it is the last block.
      */
 
     ulg high_water;
@@ -273,8 +294,40 @@ typedef struct internal_state {
      * updated to the new high water mark.
      */
 
+    int slid;
+    /* True once the window has slid with the hash tables.  Until then only
+     * the prev entries below strstart + lookahead can be on a hash chain.
+     */
+
+    int rehash;
+    /* True when the hash table holds no strings but those below strstart +
+     * lookahead, hashed from bytes that are still in the window as they
+     * were, so that lm_init() can find their buckets again and clear only
+     * those.
+     */
+
+    int passthrough;
+    /* For Z_ADAPTIVE: 1 when _tr_flush_block() found the last block
+     * incompressible, 2 while the input is stored by deflate_stored().
+     */
+
+    ulg passed;
+    /* Bytes stored since the input began to be stored for Z_ADAPTIVE. */
+
+#ifdef ZLIB_STATS
+    z_deflate_stats stats;
+    /* Counters returned by deflateGetStats(), cleared by deflateReset() */
+#endif
+
 } FAR deflate_state;
 
+#ifdef ZLIB_STATS
+#  define DSTAT(s, counter, n) ((s)->stats.counter += (n))
+#else
+#  define DSTAT(s, counter, n)
+#endif
+/* Add n to one of the counters in s->stats, or do nothing at all */
+
 /* Output a byte on the stream.
  * IN assertion: there is enough room in pending_buf.
  */
@@ -291,6 +344,15 @@ typedef struct internal_state {
  * distances are limited to MAX_DIST instead of WSIZE.
  */
 
+#define PASSTHROUGH_MIN   8192
+#define PASSTHROUGH_GAIN  5
+#define PASSTHROUGH_PROBE (1UL << 20)
+/* For Z_ADAPTIVE, a block of at least PASSTHROUGH_MIN bytes that compresses
+ * by less than one in 2^PASSTHROUGH_GAIN makes deflate() store the input that
+ * follows. After PASSTHROUGH_PROBE bytes it compresses a block again, to see
+ * whether the data has changed.
+ */
+
 #define WIN_INIT MAX_MATCH
 /* Number of bytes after end of data in window to initialize in order to avoid
    memory checker errors from longest match routines */
@@ -304,6 +366,11 @@ void ZLIB_INTERNAL _tr_flush_bits OF((deflate_state *s));
 void ZLIB_INTERNAL _tr_align OF((deflate_state *s));
 void ZLIB_INTERNAL _tr_stored_block OF((deflate_state *s, charf *buf,
                         ulg stored_len, int last));
+void ZLIB_INTERNAL _tr_fixed_start OF((deflate_state *s, int last));
+void ZLIB_INTERNAL _tr_fixed_lit OF((deflate_state *s, unsigned c));
+void ZLIB_INTERNAL _tr_fixed_dist OF((deflate_state *s, unsigned dist,
+                        unsigned lc));
+void ZLIB_INTERNAL _tr_fixed_end OF((deflate_state *s, int last));
 
 #define d_code(dist) \
    ((dist) < 256 ? _dist_code[dist] : _dist_code[256+((dist)>>7)])
@@ -315,7 +382,7 @@ void ZLIB_INTERNAL _tr_stored_block OF((deflate_state *s, charf *buf,
 #ifndef ZLIB_DEBUG
 /* Inline versions of _tr_tally for speed: */
 
-#if defined(GEN_TREES_H) || !defined(STDC)
+#ifdef GEN_TREES_H
   extern uch ZLIB_INTERNAL _length_code[];
   extern uch ZLIB_INTERNAL _dist_code[];
 #else
@@ -328,6 +395,7 @@ void ZLIB_INTERNAL _tr_stored_block OF((deflate_state *s, charf *buf,
     s->d_buf[s->last_lit] = 0; \
     s->l_buf[s->last_lit++] = cc; \
     s->dyn_ltree[cc].Freq++; \
+    DSTAT(s, literals, 1); \
     flush = (s->last_lit == s->lit_bufsize-1); \
    }
 # define _tr_tally_dist(s, distance, length, flush) \
@@ -338,6 +406,7 @@ void ZLIB_INTERNAL _tr_stored_block OF((deflate_state *s, charf *buf,
     dist--; \
     s->dyn_ltree[_length_code[len]+LITERALS+1].Freq++; \
     s->dyn_dtree[d_code(dist)].Freq++; \
+    DSTAT(s, matches, 1); \
     flush = (s->last_lit == s->lit_bufsize-1); \
   }
 #else
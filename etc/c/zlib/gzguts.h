@@ -39,6 +39,23 @@
 #  include <io.h>
 #endif
 
+/* fstat() is used to fit the buffer size to the file, and posix_fadvise() to
+   announce sequential reading */
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__APPLE__) && defined(__MACH__))
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  define GZ_FSTAT
+#endif
+
+/* a thread for compressing in the background, for the 'B' mode */
+#if !defined(NO_GZCOMPRESS) && !defined(NO_GZTHREADS) && \
+    (defined(__unix__) || defined(__unix) || \
+     (defined(__APPLE__) && defined(__MACH__)))
+#  include <pthread.h>
+#  define GZ_THREADS
+#endif
+
 #if defined(_WIN32) || defined(__CYGWIN__)
 #  define WIDECHAR
 #endif
@@ -151,9 +168,37 @@
 #  define DEF_MEM_LEVEL  MAX_MEM_LEVEL
 #endif
 
+/* file offset seek, large file capable if available (shared by gzlib.c and
+   gzread.c) */
+#if defined(_WIN32) && !defined(__BORLANDC__) && !defined(__MINGW32__) && !defined(__DMC__)
+#  define LSEEK _lseeki64
+#else
+#if defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
+#  define LSEEK lseek64
+#else
+#  define LSEEK lseek
+#endif
+#endif
+
 /* default i/o buffer size -- double this for output when reading (this and
    twice this must be able to fit in an unsigned type) */
-#define GZBUFSIZE 8192
+#ifdef MAXSEG_64K
+#  define GZBUFSIZE 8192
+#else
+#  define GZBUFSIZE 131072
+#endif
+
+/* bounds for fitting the default buffer size to the file in gz_open(): a
+   small file being read gets a smaller buffer, but not below GZBUFMIN, and a
+   preferred block size larger than the default is used, up to GZBUFMAX */
+#define GZBUFMIN 8192
+#define GZBUFMAX 1048576
+
+/* gzread() requests of this size or more are decompressed straight into the
+   caller's buffer even when they would fit in state->out -- much smaller
+   writes are slower, since more of the matches must then be copied from the
+   inflate window */
+#define GZDIRECT 131072
 
 /* gzip modes, also provide a little integrity check on the passed structure */
 #define GZ_NONE 0
@@ -166,6 +211,32 @@
 #define COPY 1      /* copy input directly */
 #define GZIP 2      /* decompress a gzip stream */
 
+/* size of the inflate window saved with each access point of an index */
+#define GZ_WINSIZE 32768U
+
+/* default distance between access points, in uncompressed bytes */
+#define GZ_SPAN 1048576L
+
+/* first eight bytes of an index file written by gzsaveindex() */
+#define GZ_IDXMAGIC "gzindex\001"
+
+/* access point in the uncompressed data, where decompression can be resumed
+   without decoding anything before it */
+typedef struct {
+    z_off64_t out;          /* offset in the uncompressed data */
+    z_off64_t in;           /* offset in the file of the first full byte */
+    int bits;               /* number of bits (1-7) from the previous byte */
+    unsigned char window[GZ_WINSIZE];   /* preceding 32K of output */
+} gz_point;
+
+/* random access index, built by gzbuildindex() or read by gzloadindex() */
+typedef struct {
+    int have;               /* number of access points in list */
+    int size;               /* number of access points allocated */
+    z_off64_t length;       /* length of the compressed data at build time */
+    gz_point *list;         /* access points, in increasing offset order */
+} gz_index;
+
 /* internal gzip file state data structure */
 typedef struct {
         /* exposed contents for gzgetc() macro */
@@ -187,9 +258,13 @@ typedef struct {
     z_off64_t start;        /* where the gzip data started, for rewinding */
     int eof;                /* true if end of input file reached */
     int past;               /* true if read requested past end */
+    unsigned trail;         /* gzip trailer bytes to skip after a raw resume */
+    gz_index *index;        /* access points for gzseek(), or NULL */
         /* just for writing */
     int level;              /* compression level */
     int strategy;           /* compression strategy */
+    int background;         /* true to compress in a thread ('B' mode) */
+    struct gz_worker_s *worker; /* that thread, or NULL if compressing here */
         /* seek request */
     z_off64_t skip;         /* amount to skip (already rewound if backwards) */
     int seek;               /* true if seek request pending */
@@ -203,6 +278,7 @@ typedef gz_state FAR *gz_statep;
 
 /* shared functions */
 void ZLIB_INTERNAL gz_error OF((gz_statep, int, const char *));
+z_off64_t ZLIB_INTERNAL gz_jump OF((gz_statep, z_off64_t));
 #if defined UNDER_CE
 char ZLIB_INTERNAL *gz_strwinerror OF((DWORD error));
 #endif
@@ -5,18 +5,9 @@
 
 #include "gzguts.h"
 
-#if defined(_WIN32) && !defined(__BORLANDC__) && !defined(__MINGW32__) && !defined(__DMC__)
-#  define LSEEK _lseeki64
-#else
-#if defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
-#  define LSEEK lseek64
-#else
-#  define LSEEK lseek
-#endif
-#endif
-
 /* Local functions */
 local void gz_reset OF((gz_statep));
+local void gz_fit OF((gz_statep));
 local gzFile gz_open OF((const void *, int, const char *));
 
 #if defined UNDER_CE
@@ -80,6 +71,7 @@ local void gz_reset(state)
         state->eof = 0;             /* not at end of file */
         state->past = 0;            /* have not read past end yet */
         state->how = LOOK;          /* look for gzip header */
+        state->trail = 0;           /* not resumed from an access point */
     }
     state->seek = 0;                /* no seek request pending */
     gz_error(state, Z_OK, NULL);    /* clear error */
@@ -87,6 +79,33 @@ local void gz_reset(state)
     state->strm.avail_in = 0;       /* no input data yet */
 }
 
+/* Fit the default buffer size to the file just opened: use the preferred
+   block size if it is larger, up to GZBUFMAX, and when reading a regular file
+   that is smaller than the buffer, shrink it to one byte more than the rest
+   of the file so that a single gz_load() reaches the end, but not below
+   GZBUFMIN.  gzbuffer() can still set any size after this. */
+local void gz_fit(state)
+    gz_statep state;
+{
+#ifdef GZ_FSTAT
+    struct stat st;
+    z_off64_t left;
+
+    if (fstat(state->fd, &st) == -1)
+        return;
+    if (st.st_blksize > 0 && (unsigned long)st.st_blksize > state->want &&
+            st.st_blksize <= GZBUFMAX)
+        state->want = (unsigned)st.st_blksize;
+    if (state->mode == GZ_READ && S_ISREG(st.st_mode)) {
+        left = (z_off64_t)st.st_size - state->start;
+        if (left < (z_off64_t)state->want)
+            state->want = left < GZBUFMIN ? GZBUFMIN : (unsigned)left + 1;
+    }
+#else
+    (void)state;
+#endif
+}
+
 /* Open a gzip file either by name or file descriptor. */
 local gzFile gz_open(path, fd, mode)
     const void *path;
@@ -114,12 +133,15 @@ local gzFile gz_open(path, fd, mode)
     state->size = 0;            /* no buffers allocated yet */
     state->want = GZBUFSIZE;    /* requested buffer size */
     state->msg = NULL;          /* no error message yet */
+    state->index = NULL;        /* no random access index */
+    state->worker = NULL;       /* no compression thread */
 
     /* interpret mode */
     state->mode = GZ_NONE;
     state->level = Z_DEFAULT_COMPRESSION;
     state->strategy = Z_DEFAULT_STRATEGY;
     state->direct = 0;
+    state->background = 0;
     while (*mode) {
         if (*mode >= '0' && *mode <= '9')
             state->level = *mode - '0';
@@ -163,6 +185,18 @@ local gzFile gz_open(path, fd, mode)
             case 'F':
                 state->strategy = Z_FIXED;
                 break;
+            case 'Q':
+                state->strategy = Z_QUICK;
+                break;
+            case 'M':
+                state->strategy = Z_MEDIUM;
+                break;
+            case 'A':
+                state->strategy = Z_ADAPTIVE;
+                break;
+            case 'B':
+                state->background = 1;
+                break;
             case 'T':
                 state->direct = 1;
                 break;
@@ -257,7 +291,14 @@ local gzFile gz_open(path, fd, mode)
     if (state->mode == GZ_READ) {
         state->start = LSEEK(state->fd, 0, SEEK_CUR);
         if (state->start == -1) state->start = 0;
+#ifdef POSIX_FADV_SEQUENTIAL
+        /* ask for more read-ahead on a file we opened */
+        if (fd == -1)
+            (void)posix_fadvise(state->fd, (off_t)state->start, 0,
+                                POSIX_FADV_SEQUENTIAL);
+#endif
     }
+    gz_fit(state);
 
     /* initialize stream */
     gz_reset(state);
@@ -410,6 +451,15 @@ z_off64_t ZEXPORT gzseek64(file, offset, whence)
         return state->x.pos;
     }
 
+    /* if reading with an index, start from the closest access point */
+    if (state->mode == GZ_READ && state->index != NULL &&
+            state->x.pos + offset >= 0) {
+        ret = state->x.pos + offset;
+        if (gz_jump(state, ret) == -1)
+            return -1;
+        offset = ret - state->x.pos;
+    }
+
     /* calculate skip amount, rewinding if needed for back seek when reading */
     if (offset < 0) {
         if (state->mode != GZ_READ)         /* writing -- can't go backwards */
@@ -8,11 +8,18 @@
 /* Local functions */
 local int gz_load OF((gz_statep, unsigned char *, unsigned, unsigned *));
 local int gz_avail OF((gz_statep));
+local int gz_init OF((gz_statep));
 local int gz_look OF((gz_statep));
 local int gz_decomp OF((gz_statep));
 local int gz_fetch OF((gz_statep));
 local int gz_skip OF((gz_statep, z_off64_t));
 local z_size_t gz_read OF((gz_statep, voidp, z_size_t));
+local int gz_addpoint OF((gz_index *, int, z_off64_t, z_off64_t, unsigned,
+                          unsigned char *));
+local void gz_freeindex OF((gz_index *));
+local void gz_put64 OF((unsigned char *, z_off64_t));
+local int gz_get64 OF((unsigned char *, z_off64_t *));
+local z_off64_t gz_length OF((gz_statep));
 
 /* Use read() to load a buffer -- return -1 on error, otherwise 0.  Read from
    state->fd, and update state->eof, state->err, and state->msg as appropriate.
@@ -79,6 +86,38 @@ local int gz_avail(state)
     return 0;
 }
 
+/* Allocate the read buffers and the inflate state.  Return -1 on error, 0 on
+   success. */
+local int gz_init(state)
+    gz_statep state;
+{
+    /* allocate buffers */
+    state->in = (unsigned char *)malloc(state->want);
+    state->out = (unsigned char *)malloc(state->want << 1);
+    if (state->in == NULL || state->out == NULL) {
+        free(state->out);
+        free(state->in);
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    state->size = state->want;
+
+    /* allocate inflate memory */
+    state->strm.zalloc = Z_NULL;
+    state->strm.zfree = Z_NULL;
+    state->strm.opaque = Z_NULL;
+    state->strm.avail_in = 0;
+    state->strm.next_in = Z_NULL;
+    if (inflateInit2(&(state->strm), 15 + 16) != Z_OK) {    /* gunzip */
+        free(state->out);
+        free(state->in);
+        state->size = 0;
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    return 0;
+}
+
 /* Look for gzip header, set up for inflate or copy.  state->x.have must be 0.
    If this is the first time in, allocate required memory.  state->how will be
    left unchanged if there is no more input data available, will be set to COPY
@@ -91,34 +130,31 @@ local int gz_avail(state)
 local int gz_look(state)
     gz_statep state;
 {
+    unsigned n;
     z_streamp strm = &(state->strm);
 
     /* allocate read buffers and inflate memory */
-    if (state->size == 0) {
-        /* allocate buffers */
-        state->in = (unsigned char *)malloc(state->want);
-        state->out = (unsigned char *)malloc(state->want << 1);
-        if (state->in == NULL || state->out == NULL) {
-            free(state->out);
-            free(state->in);
-            gz_error(state, Z_MEM_ERROR, "out of memory");
-            return -1;
-        }
-        state->size = state->want;
-
-        /* allocate inflate memory */
-        state->strm.zalloc = Z_NULL;
-        state->strm.zfree = Z_NULL;
-        state->strm.opaque = Z_NULL;
-        state->strm.avail_in = 0;
-        state->strm.next_in = Z_NULL;
-        if (inflateInit2(&(state->strm), 15 + 16) != Z_OK) {    /* gunzip */
-            free(state->out);
-            free(state->in);
-            state->size = 0;
-            gz_error(state, Z_MEM_ERROR, "out of memory");
-            return -1;
+    if (state->size == 0 && gz_init(state) == -1)
+        return -1;
+
+    /* if the member just finished was resumed from an access point, then it
+       was decoded as raw deflate data, which leaves its gzip trailer unread --
+       skip it (the check value covers data that was not decompressed, so it
+       cannot be verified) */
+    while (state->trail) {
+        if (strm->avail_in == 0) {
+            if (gz_avail(state) == -1)
+                return -1;
+            if (strm->avail_in == 0) {
+                gz_error(state, Z_BUF_ERROR, "unexpected end of file");
+                state->trail = 0;
+                return 0;
+            }
         }
+        n = strm->avail_in < state->trail ? strm->avail_in : state->trail;
+        strm->next_in += n;
+        strm->avail_in -= n;
+        state->trail -= n;
     }
 
     /* get at least the magic bytes in the input buffer */
@@ -138,7 +174,7 @@ local int gz_look(state)
        single byte is sufficient indication that it is not a gzip file) */
     if (strm->avail_in > 1 &&
             strm->next_in[0] == 31 && strm->next_in[1] == 139) {
-        inflateReset(strm);
+        inflateReset2(strm, 15 + 16);   /* may have been left raw by gz_jump */
         state->how = GZIP;
         state->direct = 0;
         return 0;
@@ -287,6 +323,74 @@ local int gz_skip(state, len)
     return 0;
 }
 
+/* Move the read position to the last access point of the index at or before
+   target, if that saves decompressing data: either because the target is
+   behind the current position, or because the access point is past the data
+   already decompressed.  The inflate state is then primed to decode raw
+   deflate data from there.  Return the resulting position on success, which
+   is unchanged if no jump was made, or -1 on error. */
+z_off64_t ZLIB_INTERNAL gz_jump(state, target)
+    gz_statep state;
+    z_off64_t target;
+{
+    int lo, hi, mid;
+    gz_point *point;
+    gz_index *index = state->index;
+    z_streamp strm = &(state->strm);
+
+    /* binary search for the last access point at or before target -- the
+       first access point is always at offset zero */
+    lo = 0;
+    hi = index->have - 1;
+    while (lo < hi) {
+        mid = lo + ((hi - lo + 1) >> 1);
+        if (index->list[mid].out <= target)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    point = index->list + lo;
+    if (target >= state->x.pos &&
+            point->out <= state->x.pos + (z_off64_t)state->x.have)
+        return state->x.pos;
+
+    /* allocate read buffers and inflate memory if not done yet */
+    if (state->size == 0 && gz_init(state) == -1)
+        return -1;
+
+    /* go to the byte holding the first bits of the access point */
+    if (LSEEK(state->fd, point->in - (point->bits ? 1 : 0), SEEK_SET) == -1) {
+        gz_error(state, Z_ERRNO, zstrerror());
+        return -1;
+    }
+    state->x.have = 0;
+    state->eof = 0;
+    state->past = 0;
+    gz_error(state, Z_OK, NULL);
+    strm->avail_in = 0;
+
+    /* resume raw inflate with the saved bits and window */
+    inflateReset2(strm, -15);
+    if (point->bits) {
+        if (gz_avail(state) == -1)
+            return -1;
+        if (strm->avail_in == 0) {
+            gz_error(state, Z_DATA_ERROR, "index does not match file");
+            return -1;
+        }
+        inflatePrime(strm, point->bits,
+                     strm->next_in[0] >> (8 - point->bits));
+        strm->next_in++;
+        strm->avail_in--;
+    }
+    inflateSetDictionary(strm, point->window, GZ_WINSIZE);
+    state->how = GZIP;
+    state->direct = 0;
+    state->trail = 8;
+    state->x.pos = point->out;
+    return state->x.pos;
+}
+
 /* Read len bytes into buf from file, or less than len up to the end of the
    input.  Return the number of bytes read.  If zero is returned, either the
    end of file was reached, or there was an error.  state->err must be
@@ -334,8 +438,11 @@ local z_size_t gz_read(state, buf, len)
         }
 
         /* need output data -- for small len or new stream load up our output
-           buffer */
-        else if (state->how == LOOK || n < (state->size << 1)) {
+           buffer (len is not small if it fills the output buffer, or when
+           decompressing also if it is GZDIRECT or more, since the input is
+           still read a buffer at a time) */
+        else if (state->how == LOOK || (n < (state->size << 1) &&
+                 (state->how == COPY || n < GZDIRECT))) {
             /* get more output, looking for header if required */
             if (gz_fetch(state) == -1)
                 return 0;
@@ -623,6 +730,353 @@ int ZEXPORT gzdirect(file)
     return state->direct;
 }
 
+/* Add an access point to index, copying the circular window whose oldest
+   byte is left bytes from its end.  Return -1 if out of memory, 0 on
+   success. */
+local int gz_addpoint(index, bits, in, out, left, window)
+    gz_index *index;
+    int bits;
+    z_off64_t in;
+    z_off64_t out;
+    unsigned left;
+    unsigned char *window;
+{
+    int size;
+    gz_point *next;
+
+    /* make room for another access point */
+    if (index->have == index->size) {
+        if ((unsigned)index->size > ((unsigned)-1 >> 2))
+            return -1;
+        size = index->size ? index->size << 1 : 8;
+        if ((size_t)size > (size_t)-1 / sizeof(gz_point))
+            return -1;
+        next = (gz_point *)realloc(index->list, sizeof(gz_point) * size);
+        if (next == NULL)
+            return -1;
+        index->list = next;
+        index->size = size;
+    }
+
+    /* fill in the access point and unwrap the window into it */
+    next = index->list + index->have;
+    next->bits = bits;
+    next->in = in;
+    next->out = out;
+    if (left)
+        memcpy(next->window, window + GZ_WINSIZE - left, left);
+    if (left < GZ_WINSIZE)
+        memcpy(next->window + left, window, GZ_WINSIZE - left);
+    index->have++;
+    return 0;
+}
+
+/* Free an index and its access points. */
+local void gz_freeindex(index)
+    gz_index *index;
+{
+    if (index != NULL) {
+        free(index->list);
+        free(index);
+    }
+}
+
+/* Store val in buf as eight bytes, least significant first. */
+local void gz_put64(buf, val)
+    unsigned char *buf;
+    z_off64_t val;
+{
+    int n;
+
+    for (n = 0; n < 8; n++) {
+        buf[n] = (unsigned char)(val & 0xff);
+        val >>= 8;
+    }
+}
+
+/* Get an eight-byte value from buf into *val.  Return -1 if it is negative or
+   does not fit in a z_off64_t, 0 otherwise. */
+local int gz_get64(buf, val)
+    unsigned char *buf;
+    z_off64_t *val;
+{
+    int n;
+    unsigned char check[8];
+
+    if (buf[7] & 0x80)
+        return -1;
+    *val = 0;
+    for (n = 7; n >= 0; n--)
+        *val = (*val << 8) + buf[n];
+    gz_put64(check, *val);
+    return memcmp(check, buf, 8) ? -1 : 0;
+}
+
+/* Return the length of the file from the start of the gzip data, leaving the
+   file position unchanged, or -1 on error. */
+local z_off64_t gz_length(state)
+    gz_statep state;
+{
+    z_off64_t cur, end;
+
+    cur = LSEEK(state->fd, 0, SEEK_CUR);
+    if (cur == -1)
+        return -1;
+    end = LSEEK(state->fd, 0, SEEK_END);
+    if (LSEEK(state->fd, cur, SEEK_SET) == -1 || end == -1)
+        return -1;
+    return end - state->start;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzbuildindex(file, span)
+    gzFile file;
+    unsigned long span;
+{
+    int ret, got, bits;
+    unsigned max = ((unsigned)-1 >> 2) + 1;
+    z_off64_t cur, totin, totout;
+    unsigned char *in, *window;
+    z_stream strm;
+    gz_index *index;
+    gz_statep state;
+
+    /* get internal structure */
+    if (file == NULL)
+        return -1;
+    state = (gz_statep)file;
+
+    /* check that we're reading and that there's no (serious) error */
+    if (state->mode != GZ_READ ||
+            (state->err != Z_OK && state->err != Z_BUF_ERROR))
+        return -1;
+    if (span == 0)
+        span = GZ_SPAN;
+
+    /* allocate the index and a separate input buffer and inflate state, so
+       that the read state is left undisturbed */
+    in = (unsigned char *)malloc(state->want);
+    window = (unsigned char *)calloc(GZ_WINSIZE, 1);
+    index = (gz_index *)malloc(sizeof(gz_index));
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_in = Z_NULL;
+    if (in == NULL || window == NULL || index == NULL ||
+            inflateInit2(&strm, 15 + 16) != Z_OK) {
+        free(index);
+        free(window);
+        free(in);
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    index->have = 0;
+    index->size = 0;
+    index->list = NULL;
+
+    /* decompress the whole file from where the gzip data starts, noting an
+       access point at the first deflate block boundary, and then at the first
+       one after each span or more uncompressed bytes */
+    ret = Z_OK;
+    totin = totout = 0;
+    strm.avail_out = 0;
+    cur = LSEEK(state->fd, 0, SEEK_CUR);
+    index->length = gz_length(state);
+    if (cur == -1 || index->length == -1 ||
+            LSEEK(state->fd, state->start, SEEK_SET) == -1)
+        ret = Z_ERRNO;
+    while (ret == Z_OK) {
+        /* get more input, and at the start of each member check that there
+           is one -- gzread() ignores anything else after the first member */
+        if (strm.avail_in < 2 && (strm.avail_in == 0 || strm.total_in == 0)) {
+            if (strm.avail_in)
+                in[0] = strm.next_in[0];
+            got = read(state->fd, in + strm.avail_in,
+                       (state->want < max ? state->want : max) - strm.avail_in);
+            if (got < 0) {
+                ret = Z_ERRNO;
+                break;
+            }
+            strm.avail_in += (unsigned)got;
+            strm.next_in = in;
+            if (got == 0 && strm.total_in)
+                break;          /* truncated, index what was there */
+        }
+        if (strm.total_in == 0 &&
+                (strm.avail_in < 2 || strm.next_in[0] != 31 ||
+                 strm.next_in[1] != 139))
+            break;              /* end of members, or not a gzip file */
+
+        /* decompress up to the end of the next deflate block, keeping the
+           last 32K of output in the circular window */
+        if (strm.avail_out == 0) {
+            strm.avail_out = GZ_WINSIZE;
+            strm.next_out = window;
+        }
+        totin += strm.avail_in;
+        totout += strm.avail_out;
+        ret = inflate(&strm, Z_BLOCK);
+        totin -= strm.avail_in;
+        totout -= strm.avail_out;
+        if (ret == Z_NEED_DICT)
+            ret = Z_DATA_ERROR;
+        if (ret == Z_STREAM_END) {
+            inflateReset(&strm);    /* look for another member */
+            ret = Z_OK;
+            continue;
+        }
+        if (ret != Z_OK)
+            break;
+
+        /* at a block boundary that is not the end of the member, add an
+           access point if it is the first one or span bytes have passed */
+        bits = strm.data_type;
+        if ((bits & 128) && !(bits & 64) && (index->have == 0 ||
+                totout - index->list[index->have - 1].out > (z_off64_t)span) &&
+                gz_addpoint(index, bits & 7, state->start + totin, totout,
+                            strm.avail_out, window) == -1)
+            ret = Z_MEM_ERROR;
+    }
+    inflateEnd(&strm);
+    free(window);
+    free(in);
+
+    /* put the file back where the read state expects it */
+    if (cur != -1 && LSEEK(state->fd, cur, SEEK_SET) == -1 && ret == Z_OK)
+        ret = Z_ERRNO;
+    if (ret != Z_OK) {
+        gz_freeindex(index);
+        gz_error(state, ret, ret == Z_ERRNO ? zstrerror() :
+                             ret == Z_MEM_ERROR ? "out of memory" :
+                             strm.msg == NULL ? "compressed data error" :
+                             strm.msg);
+        return -1;
+    }
+
+    /* replace any previous index -- a file with no gzip data gets none */
+    gz_freeindex(state->index);
+    state->index = NULL;
+    if (index->have == 0) {
+        gz_freeindex(index);
+        return 0;
+    }
+    state->index = index;
+    return index->have;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzsaveindex(file, path)
+    gzFile file;
+    const char *path;
+{
+    int n, ret;
+    unsigned char head[17];
+    gz_point *point;
+    gz_statep state;
+    FILE *out;
+
+    /* get internal structure and check that there is an index */
+    if (file == NULL || path == NULL)
+        return -1;
+    state = (gz_statep)file;
+    if (state->mode != GZ_READ || state->index == NULL)
+        return -1;
+
+    /* write the header, then each access point and its window */
+    out = fopen(path, "wb");
+    if (out == NULL)
+        return -1;
+    memcpy(head, GZ_IDXMAGIC, 8);
+    gz_put64(head + 8, state->index->length);
+    ret = fwrite(head, 1, 16, out) != 16;
+    gz_put64(head, (z_off64_t)state->index->have);
+    ret |= fwrite(head, 1, 8, out) != 8;
+    for (n = 0; n < state->index->have && !ret; n++) {
+        point = state->index->list + n;
+        gz_put64(head, point->out);
+        gz_put64(head + 8, point->in - state->start);
+        head[16] = (unsigned char)point->bits;
+        ret = fwrite(head, 1, 17, out) != 17 ||
+              fwrite(point->window, 1, GZ_WINSIZE, out) != GZ_WINSIZE;
+    }
+    ret |= fclose(out) != 0;
+    return ret ? -1 : 0;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzloadindex(file, path)
+    gzFile file;
+    const char *path;
+{
+    int ret;
+    z_off64_t have, length;
+    unsigned char head[17];
+    gz_point *point;
+    gz_index *index;
+    gz_statep state;
+    FILE *in;
+
+    /* get internal structure */
+    if (file == NULL || path == NULL)
+        return -1;
+    state = (gz_statep)file;
+    if (state->mode != GZ_READ)
+        return -1;
+
+    /* check the header, and that the index was built for a file of this
+       length */
+    in = fopen(path, "rb");
+    if (in == NULL)
+        return -1;
+    ret = fread(head, 1, 16, in) != 16 || memcmp(head, GZ_IDXMAGIC, 8) ||
+          gz_get64(head + 8, &length) || length != gz_length(state) ||
+          fread(head, 1, 8, in) != 8 || gz_get64(head, &have) ||
+          have < 1 || have > (z_off64_t)((unsigned)-1 >> 1) ||
+          (size_t)have > (size_t)-1 / sizeof(gz_point);
+    index = NULL;
+    if (!ret) {
+        index = (gz_index *)malloc(sizeof(gz_index));
+        point = (gz_point *)malloc(sizeof(gz_point) * (size_t)have);
+        if (index == NULL || point == NULL) {
+            free(point);
+            free(index);
+            fclose(in);
+            return -1;
+        }
+        index->have = 0;
+        index->size = (int)have;
+        index->length = length;
+        index->list = point;
+    }
+
+    /* read the access points, which must be in order, inside the gzip data,
+       and start at offset zero */
+    while (!ret && index->have < index->size) {
+        point = index->list + index->have;
+        ret = fread(head, 1, 17, in) != 17 ||
+              gz_get64(head, &point->out) || gz_get64(head + 8, &point->in) ||
+              head[16] > 7 ||
+              fread(point->window, 1, GZ_WINSIZE, in) != GZ_WINSIZE ||
+              point->in > length || (head[16] && point->in == 0) ||
+              (index->have == 0 ? point->out != 0 :
+                                  point->out < point[-1].out);
+        point->in += state->start;
+        point->bits = head[16];
+        index->have++;
+    }
+    fclose(in);
+    if (ret) {
+        gz_freeindex(index);
+        return -1;
+    }
+
+    /* replace any previous index */
+    gz_freeindex(state->index);
+    state->index = index;
+    return index->have;
+}
+
 /* -- see zlib.h -- */
 int ZEXPORT gzclose_r(file)
     gzFile file;
@@ -645,6 +1099,7 @@ int ZEXPORT gzclose_r(file)
         free(state->out);
         free(state->in);
     }
+    gz_freeindex(state->index);
     err = state->err == Z_BUF_ERROR ? Z_BUF_ERROR : Z_OK;
     gz_error(state, Z_OK, NULL);
     free(state->path);
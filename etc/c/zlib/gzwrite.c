@@ -7,9 +7,42 @@
 
 /* Local functions */
 local int gz_init OF((gz_statep));
+local int gz_deflate OF((z_streamp, unsigned char *, unsigned,
+                         unsigned char **, int, int));
 local int gz_comp OF((gz_statep, int));
 local int gz_zero OF((gz_statep, z_off64_t));
 local z_size_t gz_write OF((gz_statep, voidpc, z_size_t));
+#ifdef GZ_THREADS
+local int gz_start OF((gz_statep));
+local void *gz_work OF((void *));
+local int gz_wait OF((gz_statep));
+local int gz_post OF((gz_statep, int));
+local void gz_stop OF((gz_statep));
+
+/* Compression thread for the 'B' mode.  The thread owns its deflate stream
+   and output buffer and does the write() calls.  The input it compresses is
+   a copy of what has been gathered in state->in, so that the application can
+   fill state->in again while the copy is compressed.  busy is set by gz_post()
+   and cleared by the thread when it is done, both with lock held, and the
+   other members are only touched by the side that busy gives them to. */
+typedef struct gz_worker_s {
+    pthread_t thread;       /* the compression thread */
+    pthread_mutex_t lock;   /* protects busy and quit */
+    pthread_cond_t cond;    /* signals a change of busy or quit */
+    int busy;               /* true while a job is posted or running */
+    int quit;               /* true to end the thread */
+    int fd;                 /* file to write */
+    unsigned size;          /* size of in and out */
+    unsigned char *in;      /* input for the posted job */
+    unsigned len;           /* amount of input at in */
+    int flush;              /* flush for the posted job */
+    int err;                /* Z_OK, Z_ERRNO or Z_STREAM_ERROR, sticky */
+    int errnum;             /* errno for Z_ERRNO */
+    unsigned char *out;     /* output buffer */
+    unsigned char *next;    /* next output to write */
+    z_stream strm;          /* deflate stream used by the thread */
+} gz_worker;
+#endif
 
 /* Initialize state for writing a gzip file.  Mark initialization by setting
    state->size to non-zero.  Return -1 on a memory allocation failure, or 0 on
@@ -27,6 +60,14 @@ local int gz_init(state)
         return -1;
     }
 
+#ifdef GZ_THREADS
+    /* compress in a thread if requested, or here if it can't be started */
+    if (state->background && !state->direct && gz_start(state) == 0) {
+        state->size = state->want;
+        return 0;
+    }
+#endif
+
     /* only need output buffer and deflate state if compressing */
     if (!state->direct) {
         /* allocate output buffer */
@@ -64,24 +105,78 @@ local int gz_init(state)
     return 0;
 }
 
+/* Run deflate() on the input at strm->next_in until it produces no more
+   output, and write the output to fd.  The whole buffer out of size bytes
+   is filled before it is written, unless flushing, and *next points to the
+   output not written yet.  Return Z_OK, Z_ERRNO if write() fails, with errno
+   set, or Z_STREAM_ERROR if deflate() does. */
+local int gz_deflate(strm, out, size, next, fd, flush)
+    z_streamp strm;
+    unsigned char *out;
+    unsigned size;
+    unsigned char **next;
+    int fd;
+    int flush;
+{
+    int ret, writ;
+    unsigned have, put, max = ((unsigned)-1 >> 2) + 1;
+
+    ret = Z_OK;
+    do {
+        /* write out current buffer contents if full, or if flushing, but if
+           doing Z_FINISH then don't write until we get to Z_STREAM_END */
+        if (strm->avail_out == 0 || (flush != Z_NO_FLUSH &&
+            (flush != Z_FINISH || ret == Z_STREAM_END))) {
+            while (strm->next_out > *next) {
+                put = strm->next_out - *next > (int)max ? max :
+                      (unsigned)(strm->next_out - *next);
+                writ = write(fd, *next, put);
+                if (writ < 0)
+                    return Z_ERRNO;
+                *next += writ;
+            }
+            if (strm->avail_out == 0) {
+                strm->avail_out = size;
+                strm->next_out = out;
+                *next = out;
+            }
+        }
+
+        /* compress */
+        have = strm->avail_out;
+        ret = deflate(strm, flush);
+        if (ret == Z_STREAM_ERROR)
+            return Z_STREAM_ERROR;
+        have -= strm->avail_out;
+    } while (have);
+    return Z_OK;
+}
+
 /* Compress whatever is at avail_in and next_in and write to the output file.
    Return -1 if there is an error writing to the output file or if gz_init()
    fails to allocate memory, otherwise 0.  flush is assumed to be a valid
    deflate() flush value.  If flush is Z_FINISH, then the deflate() state is
    reset to start a new gzip stream.  If gz->direct is true, then simply write
-   to the output file without compressing, and ignore flush. */
+   to the output file without compressing, and ignore flush.  With a
+   compression thread, the input is handed to it, and only a flush waits for
+   the thread to finish. */
 local int gz_comp(state, flush)
     gz_statep state;
     int flush;
 {
     int ret, writ;
-    unsigned have, put, max = ((unsigned)-1 >> 2) + 1;
+    unsigned put, max = ((unsigned)-1 >> 2) + 1;
     z_streamp strm = &(state->strm);
 
     /* allocate memory if this is the first time through */
     if (state->size == 0 && gz_init(state) == -1)
         return -1;
 
+#ifdef GZ_THREADS
+    if (state->worker != NULL)
+        return gz_post(state, flush);
+#endif
+
     /* write directly if requested */
     if (state->direct) {
         while (strm->avail_in) {
@@ -98,39 +193,17 @@ local int gz_comp(state, flush)
     }
 
     /* run deflate() on provided input until it produces no more output */
-    ret = Z_OK;
-    do {
-        /* write out current buffer contents if full, or if flushing, but if
-           doing Z_FINISH then don't write until we get to Z_STREAM_END */
-        if (strm->avail_out == 0 || (flush != Z_NO_FLUSH &&
-            (flush != Z_FINISH || ret == Z_STREAM_END))) {
-            while (strm->next_out > state->x.next) {
-                put = strm->next_out - state->x.next > (int)max ? max :
-                      (unsigned)(strm->next_out - state->x.next);
-                writ = write(state->fd, state->x.next, put);
-                if (writ < 0) {
-                    gz_error(state, Z_ERRNO, zstrerror());
-                    return -1;
-                }
-                state->x.next += writ;
-            }
-            if (strm->avail_out == 0) {
-                strm->avail_out = state->size;
-                strm->next_out = state->out;
-                state->x.next = state->out;
-            }
-        }
-
-        /* compress */
-        have = strm->avail_out;
-        ret = deflate(strm, flush);
-        if (ret == Z_STREAM_ERROR) {
-            gz_error(state, Z_STREAM_ERROR,
-                      "internal error: deflate stream corrupt");
-            return -1;
-        }
-        have -= strm->avail_out;
-    } while (have);
+    ret = gz_deflate(strm, state->out, state->size, &(state->x.next),
+                     state->fd, flush);
+    if (ret == Z_ERRNO) {
+        gz_error(state, Z_ERRNO, zstrerror());
+        return -1;
+    }
+    if (ret == Z_STREAM_ERROR) {
+        gz_error(state, Z_STREAM_ERROR,
+                  "internal error: deflate stream corrupt");
+        return -1;
+    }
 
     /* if that completed a deflate stream, allow another to start */
     if (flush == Z_FINISH)
@@ -140,6 +213,172 @@ local int gz_comp(state, flush)
     return 0;
 }
 
+#ifdef GZ_THREADS
+/* Allocate the buffers and deflate state of a compression thread and start
+   it.  Return -1 if any of that fails, leaving state->worker NULL, or 0 on
+   success. */
+local int gz_start(state)
+    gz_statep state;
+{
+    gz_worker *w;
+
+    w = (gz_worker *)malloc(sizeof(gz_worker));
+    if (w == NULL)
+        return -1;
+    w->in = (unsigned char *)malloc(state->want);
+    w->out = (unsigned char *)malloc(state->want);
+    if (w->in == NULL || w->out == NULL)
+        goto fail_buffers;
+    w->strm.zalloc = Z_NULL;
+    w->strm.zfree = Z_NULL;
+    w->strm.opaque = Z_NULL;
+    if (deflateInit2(&(w->strm), state->level, Z_DEFLATED, MAX_WBITS + 16,
+                     DEF_MEM_LEVEL, state->strategy) != Z_OK)
+        goto fail_buffers;
+    w->strm.next_in = NULL;
+    w->strm.avail_out = state->want;
+    w->strm.next_out = w->out;
+    w->next = w->out;
+    w->size = state->want;
+    w->fd = state->fd;
+    w->busy = 0;
+    w->quit = 0;
+    w->err = Z_OK;
+    if (pthread_mutex_init(&(w->lock), NULL))
+        goto fail_deflate;
+    if (pthread_cond_init(&(w->cond), NULL))
+        goto fail_lock;
+    if (pthread_create(&(w->thread), NULL, gz_work, w))
+        goto fail_cond;
+    state->worker = w;
+    return 0;
+
+  fail_cond:
+    pthread_cond_destroy(&(w->cond));
+  fail_lock:
+    pthread_mutex_destroy(&(w->lock));
+  fail_deflate:
+    (void)deflateEnd(&(w->strm));
+  fail_buffers:
+    free(w->out);
+    free(w->in);
+    free(w);
+    return -1;
+}
+
+/* The compression thread: compress and write each posted job, until told to
+   quit.  After an error, jobs are dropped and the error is kept. */
+local void *gz_work(arg)
+    void *arg;
+{
+    gz_worker *w = (gz_worker *)arg;
+    int ret;
+
+    pthread_mutex_lock(&(w->lock));
+    for (;;) {
+        while (!w->busy && !w->quit)
+            pthread_cond_wait(&(w->cond), &(w->lock));
+        if (!w->busy)
+            break;
+        pthread_mutex_unlock(&(w->lock));
+
+        if (w->err == Z_OK) {
+            w->strm.next_in = w->in;
+            w->strm.avail_in = w->len;
+            ret = gz_deflate(&(w->strm), w->out, w->size, &(w->next), w->fd,
+                             w->flush);
+            if (ret == Z_ERRNO)
+                w->errnum = errno;
+            else if (ret == Z_OK && w->flush == Z_FINISH)
+                deflateReset(&(w->strm));
+            w->err = ret;
+        }
+
+        pthread_mutex_lock(&(w->lock));
+        w->busy = 0;
+        pthread_cond_broadcast(&(w->cond));
+    }
+    pthread_mutex_unlock(&(w->lock));
+    return NULL;
+}
+
+/* Wait for the compression thread to finish its job, and report an error
+   from it.  Return -1 on an error, which stays reported, or 0 otherwise. */
+local int gz_wait(state)
+    gz_statep state;
+{
+    gz_worker *w = state->worker;
+
+    pthread_mutex_lock(&(w->lock));
+    while (w->busy)
+        pthread_cond_wait(&(w->cond), &(w->lock));
+    pthread_mutex_unlock(&(w->lock));
+    if (w->err == Z_ERRNO) {
+        errno = w->errnum;
+        gz_error(state, Z_ERRNO, zstrerror());
+        return -1;
+    }
+    if (w->err == Z_STREAM_ERROR) {
+        gz_error(state, Z_STREAM_ERROR,
+                  "internal error: deflate stream corrupt");
+        return -1;
+    }
+    return 0;
+}
+
+/* Hand the input at avail_in and next_in to the compression thread, a
+   buffer at a time, leaving avail_in zero.  Each piece is copied once the
+   thread is done with the previous one.  If flushing, wait until the thread
+   has written everything.  Return -1 on an error, or 0 on success. */
+local int gz_post(state, flush)
+    gz_statep state;
+    int flush;
+{
+    unsigned n;
+    gz_worker *w = state->worker;
+    z_streamp strm = &(state->strm);
+
+    if (strm->avail_in == 0 && flush == Z_NO_FLUSH)
+        return 0;
+    do {
+        if (gz_wait(state) == -1)
+            return -1;
+        n = strm->avail_in > w->size ? w->size : strm->avail_in;
+        memcpy(w->in, strm->next_in, n);
+        strm->next_in += n;
+        strm->avail_in -= n;
+        w->len = n;
+        w->flush = strm->avail_in ? Z_NO_FLUSH : flush;
+        pthread_mutex_lock(&(w->lock));
+        w->busy = 1;
+        pthread_cond_broadcast(&(w->cond));
+        pthread_mutex_unlock(&(w->lock));
+    } while (strm->avail_in);
+    return flush == Z_NO_FLUSH ? 0 : gz_wait(state);
+}
+
+/* End the compression thread, which must not be busy, and free its
+   resources. */
+local void gz_stop(state)
+    gz_statep state;
+{
+    gz_worker *w = state->worker;
+
+    pthread_mutex_lock(&(w->lock));
+    w->quit = 1;
+    pthread_cond_broadcast(&(w->cond));
+    pthread_mutex_unlock(&(w->lock));
+    pthread_join(w->thread, NULL);
+    pthread_cond_destroy(&(w->cond));
+    pthread_mutex_destroy(&(w->lock));
+    (void)deflateEnd(&(w->strm));
+    free(w->out);
+    free(w->in);
+    free(w);
+    state->worker = NULL;
+}
+#endif
+
 /* Compress len zeros to output.  Return -1 on a write error or memory
    allocation failure by gz_comp(), or 0 on success. */
 local int gz_zero(state, len)
@@ -616,6 +855,13 @@ int ZEXPORT gzsetparams(file, level, strategy)
         /* flush previous input with previous parameters before changing */
         if (strm->avail_in && gz_comp(state, Z_BLOCK) == -1)
             return state->err;
+#ifdef GZ_THREADS
+        if (state->worker != NULL) {
+            if (gz_wait(state) == -1)
+                return state->err;
+            strm = &(state->worker->strm);
+        }
+#endif
         deflateParams(strm, level, strategy);
     }
     state->level = level;
@@ -649,6 +895,15 @@ int ZEXPORT gzclose_w(file)
     /* flush, free memory, and close file */
     if (gz_comp(state, Z_FINISH) == -1)
         ret = state->err;
+#ifdef GZ_THREADS
+    if (state->worker != NULL) {
+        if (gz_wait(state) == -1)
+            ret = state->err;
+        gz_stop(state);
+        free(state->in);
+    }
+    else
+#endif
     if (state->size) {
         if (!state->direct) {
             (void)deflateEnd(&(state->strm));
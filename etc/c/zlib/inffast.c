@@ -46,7 +46,287 @@
       bytes, which is the maximum length that can be coded.  inflate_fast()
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
+
+    - With INFLATE_WIDE_TABLES, a root table entry may decode two literals at
+      once.  Both codes fit in the root table bits, so the input needed is
+      no more than for a single code, and the two bytes fit in the output
+      space kept for a match.
  */
+#ifdef INFLATE_FAST64
+
+/*
+   Version for INFLATE_FAST64.  The differences from the one below are:
+
+    - hold is 64 bits, and is refilled at the top of each loop with a single
+      unaligned load of eight bytes, leaving 56 to 63 bits in hold.  Since a
+      length/distance pair takes at most 48 bits, no other refills are needed.
+      The bits loaded beyond bits are the same input that the next load would
+      put there, so or-ing them in again is harmless.  The entry requirements
+      are strm->avail_in >= 8 and strm->avail_out >= 273 (see inffast.h).
+
+    - Window copies are done with zmemcpy(), and copies from the output with
+      copy_match(), which may write up to 15 bytes past the end of the match.
+ */
+
+typedef unsigned long long hold_t;      /* 64-bit bit buffer */
+
+local unsigned char FAR *copy_match OF((unsigned char FAR *out,
+                                        unsigned dist, unsigned len));
+
+/* Copy a match of len bytes from dist bytes back in the output to out, and
+   return the end of the match.  If dist is less than eight, the pattern is
+   first doubled until it spans eight bytes -- copying from the same start
+   with a distance that is a multiple of the pattern length gives the same
+   bytes.  Then eight or sixteen bytes are copied at a time, which is safe
+   since each load only reads bytes already written. */
+local unsigned char FAR *copy_match(out, dist, len)
+    unsigned char FAR *out;
+    unsigned dist;
+    unsigned len;
+{
+    unsigned char FAR *from = out - dist;
+    unsigned char FAR *end = out + len;
+
+    while (dist < 8 && out < end) {
+        zmemcpy(out, from, dist);
+        out += dist;
+        dist <<= 1;
+    }
+    if (dist >= 16)
+        while (out < end) {
+            zmemcpy(out, from, 16);
+            out += 16;
+            from += 16;
+        }
+    else
+        while (out < end) {
+            zmemcpy(out, from, 8);
+            out += 8;
+            from += 8;
+        }
+    return end;
+}
+
+void ZLIB_INTERNAL inflate_fast(strm, start)
+z_streamp strm;
+unsigned start;         /* inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    z_const unsigned char FAR *in;      /* local strm->next_in */
+    z_const unsigned char FAR *last;    /* have enough input while in < last */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned wnext;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    hold_t hold;                /* local strm->hold */
+    hold_t word;                /* next eight bytes of input */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code here;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_LEFT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    wnext = state->wnext;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        zmemcpy(&word, in, 8);
+        hold |= word << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+        here = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(here.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(here.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, here.val >= 0x20 && here.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", here.val));
+            *out++ = (unsigned char)(here.val);
+        }
+#ifdef INFLATE_WIDE_TABLES
+        else if (op & 128) {                    /* literal pair */
+            Tracevv((stderr, "inflate:         literals 0x%02x 0x%02x\n",
+                    here.val & 0xff, here.val >> 8));
+            out[0] = (unsigned char)(here.val);
+            out[1] = (unsigned char)(here.val >> 8);
+            out += 2;
+        }
+#endif
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(here.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            here = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(here.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(here.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(here.val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        if (state->sane) {
+                            strm->msg =
+                                (char *)"invalid distance too far back";
+                            state->mode = BAD;
+                            break;
+                        }
+#ifdef INFLATE_ALLOW_INVALID_DISTANCE_TOOFAR_ARRR
+                        if (len <= op - whave) {
+                            do {
+                                *out++ = 0;
+                            } while (--len);
+                            continue;
+                        }
+                        len -= op - whave;
+                        do {
+                            *out++ = 0;
+                        } while (--op > whave);
+                        if (op == 0) {
+                            from = out - dist;
+                            do {
+                                *out++ = *from++;
+                            } while (--len);
+                            continue;
+                        }
+#endif
+                    }
+                    from = window;
+                    if (wnext == 0) {           /* very common case */
+                        from += wsize - op;
+                    }
+                    else if (wnext < op) {      /* wrap around window */
+                        from += wsize + wnext - op;
+                        op -= wnext;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            zmemcpy(out, from, op);
+                            out += op;
+                            from = window;
+                            op = wnext;         /* then from start of window */
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += wnext - op;
+                    }
+                    if (op < len) {             /* some from window */
+                        len -= op;
+                        zmemcpy(out, from, op);
+                        out += op;
+                        out = copy_match(out, dist, len);   /* rest */
+                    }
+                    else {
+                        zmemcpy(out, from, len);
+                        out += len;
+                    }
+                }
+                else                    /* copy direct from output */
+                    out = copy_match(out, dist, len);
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                here = dcode[here.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            here = lcode[here.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes, and clear the bits above bits that were loaded
+       ahead */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= ((hold_t)1 << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+        (INFLATE_FAST_MIN_HAVE - 1) + (last - in) :
+        (INFLATE_FAST_MIN_HAVE - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+        (INFLATE_FAST_MIN_LEFT - 1) + (end - out) :
+        (INFLATE_FAST_MIN_LEFT - 1) - (out - end));
+    state->hold = (unsigned long)hold;
+    state->bits = bits;
+    return;
+}
+
+#else /* !INFLATE_FAST64 */
+
 void ZLIB_INTERNAL inflate_fast(strm, start)
 z_streamp strm;
 unsigned start;         /* inflate()'s starting value for strm->avail_out */
@@ -119,6 +399,15 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                     "inflate:         literal 0x%02x\n", here.val));
             *out++ = (unsigned char)(here.val);
         }
+#ifdef INFLATE_WIDE_TABLES
+        else if (op & 128) {                    /* literal pair */
+            Tracevv((stderr, "inflate:         literals 0x%02x 0x%02x\n",
+                    here.val & 0xff, here.val >> 8));
+            out[0] = (unsigned char)(here.val);
+            out[1] = (unsigned char)(here.val >> 8);
+            out += 2;
+        }
+#endif
         else if (op & 16) {                     /* length base */
             len = (unsigned)(here.val);
             op &= 15;                           /* number of extra bits */
@@ -306,6 +595,8 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     return;
 }
 
+#endif /* INFLATE_FAST64 */
+
 /*
    inflate_fast() speedups that turned out slower (on a PowerPC G3 750CXe):
    - Using bit fields for code structure
@@ -8,4 +8,28 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* INFLATE_FAST64 selects the version of inflate_fast() that keeps a 64-bit
+   bit buffer, refilled with one unaligned eight-byte load per code, and
+   copies matches eight or sixteen bytes at a time.  It needs a 64-bit
+   little-endian processor, and is ignored otherwise. */
+#if defined(INFLATE_FAST64) && (defined(ASMINF) || \
+    !(defined(__x86_64__) || defined(_M_X64) || defined(_M_ARM64) || \
+      (defined(__GNUC__) && defined(__SIZEOF_POINTER__) && \
+       __SIZEOF_POINTER__ == 8 && defined(__BYTE_ORDER__) && \
+       __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)))
+#  undef INFLATE_FAST64
+#endif
+
+/* inflate() and inflateBack() call inflate_fast() only when at least this
+   much input is available and this much output space is left.  The 64-bit
+   version reads eight bytes at a time, and its chunked match copy may write
+   up to 15 bytes past the end of a 258-byte match. */
+#ifdef INFLATE_FAST64
+#  define INFLATE_FAST_MIN_HAVE 8
+#  define INFLATE_FAST_MIN_LEFT 273
+#else
+#  define INFLATE_FAST_MIN_HAVE 6
+#  define INFLATE_FAST_MIN_LEFT 258
+#endif
+
 void ZLIB_INTERNAL inflate_fast OF((z_streamp strm, unsigned start));
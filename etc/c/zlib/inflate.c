@@ -137,6 +137,9 @@ z_streamp strm;
     state->lencode = state->distcode = state->next = state->codes;
     state->sane = 1;
     state->back = -1;
+#ifdef ZLIB_STATS
+    zmemzero(&state->stats, sizeof(state->stats));
+#endif
     Tracev((stderr, "inflate: reset\n"));
     return Z_OK;
 }
@@ -151,6 +154,8 @@ z_streamp strm;
     state->wsize = 0;
     state->whave = 0;
     state->wnext = 0;
+    state->nowin = 0;
+    state->outhave = 0;
     return inflateResetKeep(strm);
 }
 
@@ -636,6 +641,8 @@ int flush;
     code last;                  /* parent table entry */
     unsigned len;               /* length to copy for repeats, bits to drop */
     int ret;                    /* return code */
+    int borrow;                 /* true if earlier output is the window */
+    unsigned char FAR *keep;    /* allocated window, set aside meanwhile */
 #ifdef GUNZIP
     unsigned char hbuf[4];      /* buffer for gzip header crc calculation */
 #endif
@@ -652,6 +659,18 @@ int flush;
     in = have;
     out = left;
     ret = Z_OK;
+
+    /* After inflateNoWindow(), the window is the output of earlier calls,
+       which ends where the output of this call starts.  Distances are then
+       resolved as for a full window that has not wrapped around. */
+    borrow = state->nowin && state->mode < BAD;
+    keep = state->window;
+    if (borrow) {
+        state->window = put - state->outhave;
+        state->wsize = state->whave = state->outhave;
+        state->wnext = 0;
+    }
+
     for (;;)
         switch (state->mode) {
         case HEAD:
@@ -842,6 +861,10 @@ int flush;
         case DICT:
             if (state->havedict == 0) {
                 RESTORE();
+                if (borrow) {           /* as at inf_leave, with no output */
+                    state->window = keep;
+                    state->wsize = state->whave = 0;
+                }
                 return Z_NEED_DICT;
             }
             strm->adler = state->check = adler32(0L, Z_NULL, 0);
@@ -862,12 +885,14 @@ int flush;
                 Tracev((stderr, "inflate:     stored block%s\n",
                         state->last ? " (last)" : ""));
                 state->mode = STORED;
+                ISTAT(state, stored_blocks, 1);
                 break;
             case 1:                             /* fixed block */
                 fixedtables(state);
                 Tracev((stderr, "inflate:     fixed codes block%s\n",
                         state->last ? " (last)" : ""));
                 state->mode = LEN_;             /* decode codes */
+                ISTAT(state, fixed_blocks, 1);
                 if (flush == Z_TREES) {
                     DROPBITS(2);
                     goto inf_leave;
@@ -877,6 +902,7 @@ int flush;
                 Tracev((stderr, "inflate:     dynamic codes block%s\n",
                         state->last ? " (last)" : ""));
                 state->mode = TABLE;
+                ISTAT(state, dynamic_blocks, 1);
                 break;
             case 3:
                 strm->msg = (char *)"invalid block type";
@@ -1015,11 +1041,12 @@ int flush;
             }
 
             /* build code tables -- note: do not change the lenbits or distbits
-               values here (9 and 6) without reading the comments in inftrees.h
-               concerning the ENOUGH constants, which depend on those values */
+               values here (INFLATE_LENBITS and INFLATE_DISTBITS) without
+               reading the comments in inftrees.h concerning the ENOUGH
+               constants, which depend on those values */
             state->next = state->codes;
             state->lencode = (const code FAR *)(state->next);
-            state->lenbits = 9;
+            state->lenbits = INFLATE_LENBITS;
             ret = inflate_table(LENS, state->lens, state->nlen, &(state->next),
                                 &(state->lenbits), state->work);
             if (ret) {
@@ -1028,7 +1055,7 @@ int flush;
                 break;
             }
             state->distcode = (const code FAR *)(state->next);
-            state->distbits = 6;
+            state->distbits = INFLATE_DISTBITS;
             ret = inflate_table(DISTS, state->lens + state->nlen, state->ndist,
                             &(state->next), &(state->distbits), state->work);
             if (ret) {
@@ -1042,9 +1069,12 @@ int flush;
         case LEN_:
             state->mode = LEN;
         case LEN:
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_HAVE &&
+                left >= INFLATE_FAST_MIN_LEFT) {
                 RESTORE();
                 inflate_fast(strm, out);
+                ISTAT(state, fast_calls, 1);
+                ISTAT(state, fast_out, left - strm->avail_out);
                 LOAD();
                 if (state->mode == TYPE)
                     state->back = -1;
@@ -1053,6 +1083,7 @@ int flush;
             state->back = 0;
             for (;;) {
                 here = state->lencode[BITS(state->lenbits)];
+                LIT_PAIR_FIRST(here);
                 if ((unsigned)(here.bits) <= bits) break;
                 PULLBYTE();
             }
@@ -1247,12 +1278,22 @@ int flush;
     /*
        Return from inflate(), updating the total counts and the check value.
        If there was no progress during the inflate() call, return a buffer
-       error.  Call updatewindow() to create and/or update the window state.
-       Note: a memory error from inflate() is non-recoverable.
+       error.  Call updatewindow() to create and/or update the window state,
+       or after inflateNoWindow() just count the output that the window has
+       grown by.  Note: a memory error from inflate() is non-recoverable.
      */
   inf_leave:
     RESTORE();
-    if (state->wsize || (out != strm->avail_out && state->mode < BAD &&
+    if (borrow) {
+        copy = 1U << state->wbits;
+        if (out - strm->avail_out >= copy - state->outhave)
+            state->outhave = copy;
+        else
+            state->outhave += out - strm->avail_out;
+        state->window = keep;
+        state->wsize = state->whave = 0;
+    }
+    else if (state->wsize || (out != strm->avail_out && state->mode < BAD &&
             (state->mode < CHECK || flush != Z_FINISH)))
         if (updatewindow(strm, strm->next_out, out - strm->avail_out)) {
             state->mode = MEM;
@@ -1323,7 +1364,7 @@ uInt dictLength;
     /* check state */
     if (inflateStateCheck(strm)) return Z_STREAM_ERROR;
     state = (struct inflate_state FAR *)strm->state;
-    if (state->wrap != 0 && state->mode != DICT)
+    if ((state->wrap != 0 && state->mode != DICT) || state->nowin)
         return Z_STREAM_ERROR;
 
     /* check for correct dictionary identifier */
@@ -1363,6 +1404,37 @@ gz_headerp head;
     return Z_OK;
 }
 
+int ZEXPORT inflateGetStats(strm, stats)
+z_streamp strm;
+z_inflate_stats *stats;
+{
+    if (inflateStateCheck(strm) || stats == Z_NULL) return Z_STREAM_ERROR;
+#ifdef ZLIB_STATS
+    {
+        struct inflate_state FAR *state;
+
+        state = (struct inflate_state FAR *)strm->state;
+        *stats = state->stats;
+        stats->slow_out = strm->total_out - stats->fast_out;
+    }
+    return Z_OK;
+#else
+    return Z_STREAM_ERROR;
+#endif
+}
+
+int ZEXPORT inflateNoWindow(strm)
+z_streamp strm;
+{
+    struct inflate_state FAR *state;
+
+    if (inflateStateCheck(strm)) return Z_STREAM_ERROR;
+    state = (struct inflate_state FAR *)strm->state;
+    if (state->wsize != 0 || state->havedict) return Z_STREAM_ERROR;
+    state->nowin = 1;
+    return Z_OK;
+}
+
 /*
    Search buf[0..len-1] for the pattern: 0, 0, 0xff, 0xff.  Return when found
    or when out of input.  When called, *have is the number of pattern bytes
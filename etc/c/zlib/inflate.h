@@ -97,6 +97,8 @@ struct inflate_state {
     unsigned whave;             /* valid bytes in the window */
     unsigned wnext;             /* window write index */
     unsigned char FAR *window;  /* allocated sliding window, if needed */
+    int nowin;                  /* true if earlier output is the window */
+    unsigned outhave;           /* bytes of earlier output usable as window */
         /* bit accumulator */
     unsigned long hold;         /* input bit accumulator */
     unsigned bits;              /* number of bits in "in" */
@@ -122,4 +124,13 @@ struct inflate_state {
     int sane;                   /* if false, allow invalid distance too far */
     int back;                   /* bits back of last unprocessed length/lit */
     unsigned was;               /* initial length of match */
+#ifdef ZLIB_STATS
+    z_inflate_stats stats;      /* counters for inflateGetStats() */
+#endif
 };
+
+#ifdef ZLIB_STATS
+#  define ISTAT(state, counter, n) ((state)->stats.counter += (n))
+#else
+#  define ISTAT(state, counter, n)
+#endif
@@ -297,6 +297,30 @@ unsigned short FAR *work;
         next[huff] = here;
     }
 
+#ifdef INFLATE_WIDE_TABLES
+    /* make literal pairs in the root table of a literal/length code -- the
+       code of the second literal is in the index bits above the first code,
+       at the index with those bits moved down, which is lower and so already
+       visited */
+    if (type == LENS) {
+        code second;            /* entry for the bits after the first code */
+
+        next = *table;
+        for (fill = 0; fill < (1U << root); fill++) {
+            here = next[fill];
+            if (here.op != 0 || here.bits >= root)
+                continue;
+            second = next[fill >> here.bits];
+            LIT_PAIR_FIRST(second);
+            if (second.op != 0 || here.bits + second.bits > root)
+                continue;
+            next[fill].op = (unsigned char)(128 + here.bits);
+            next[fill].bits = (unsigned char)(here.bits + second.bits);
+            next[fill].val = (unsigned short)(here.val + (second.val << 8));
+        }
+    }
+#endif
+
     /* set return parameters */
     *table += used;
     *bits = root;
@@ -33,7 +33,37 @@ typedef struct {
     0001eeee - length or distance, eeee is the number of extra bits
     01100000 - end of block
     01000000 - invalid code
+    1000bbbb - two literals, bbbb is the number of bits in the first one
+
+   A literal pair is only made in the root table of literal/length codes with
+   INFLATE_WIDE_TABLES, when the codes of both literals fit in the root index
+   bits.  bits is then the sum of both code lengths, and val holds the first
+   literal in the low byte and the second literal in the high byte.  Decoders
+   that take one symbol at a time use LIT_PAIR_FIRST() to see only the first
+   literal.
  */
+#ifdef INFLATE_WIDE_TABLES
+#  define LIT_PAIR_FIRST(here) \
+    if (here.op & 128) { \
+        here.bits = here.op & 15; \
+        here.val &= 0xff; \
+        here.op = 0; \
+    }
+#else
+#  define LIT_PAIR_FIRST(here)
+#endif
+
+/* INFLATE_WIDE_TABLES selects larger root tables for dynamic blocks, so that
+   fewer codes need a second-level lookup, and makes literal pairs in the root
+   table of literal/length codes.  The root table sizes for dynamic blocks are
+   INFLATE_LENBITS and INFLATE_DISTBITS. */
+#ifdef INFLATE_WIDE_TABLES
+#  define INFLATE_LENBITS 10
+#  define INFLATE_DISTBITS 8
+#else
+#  define INFLATE_LENBITS 9
+#  define INFLATE_DISTBITS 6
+#endif
 
 /* Maximum size of the dynamic table.  The maximum number of code structures is
    1444, which is the sum of 852 for literal/length codes and 592 for distance
@@ -42,12 +72,19 @@ typedef struct {
    program are the number of symbols, the initial root table size, and the
    maximum bit length of a code.  "enough 286 9 15" for literal/length codes
    returns returns 852, and "enough 30 6 15" for distance codes returns 592.
-   The initial root table size (9 or 6) is found in the fifth argument of the
-   inflate_table() calls in inflate.c and infback.c.  If the root table size is
-   changed, then these maximum sizes would be need to be recalculated and
-   updated. */
-#define ENOUGH_LENS 852
-#define ENOUGH_DISTS 592
+   With INFLATE_WIDE_TABLES, "enough 286 10 15" returns 1332 and "enough 30 8
+   15" returns 400, for 1732 code structures.  The initial root table sizes
+   are INFLATE_LENBITS and INFLATE_DISTBITS, which are used in the fifth
+   argument of the inflate_table() calls in inflate.c and infback.c.  If the
+   root table size is changed, then these maximum sizes would be need to be
+   recalculated and updated. */
+#ifdef INFLATE_WIDE_TABLES
+#  define ENOUGH_LENS 1332
+#  define ENOUGH_DISTS 400
+#else
+#  define ENOUGH_LENS 852
+#  define ENOUGH_DISTS 592
+#endif
 #define ENOUGH (ENOUGH_LENS+ENOUGH_DISTS)
 
 /* Type of code to build for inflate_table() */
@@ -3,7 +3,10 @@
 MODEL=32
 CC=gcc
 LD=link
-CFLAGS=-O -m$(MODEL)
+CFLAGS=-O -m$(MODEL) -DINFLATE_WIDE_TABLES
+ifeq ($(MODEL),64)
+CFLAGS+=-DINFLATE_FAST64 -DDEFLATE_BITS64
+endif
 LDFLAGS=
 O=.o
 
@@ -77,19 +80,34 @@ example.o: example.c zlib.h zconf.h
 minigzip.o: minigzip.c zlib.h zconf.h
 	"$(CC)" -c $(cvarsdll) $(CFLAGS) $*.c
 
+zbench.o: zbench.c zlib.h zconf.h
+	"$(CC)" -c $(CFLAGS) $*.c
+
 zlib.a: $(OBJS)
 	ar -r $@ $(OBJS)
 
 example: example.o zlib.a
-	"$(CC)" $(CFLAGS) -o $@ example.o zlib.a -g
+	"$(CC)" $(CFLAGS) -o $@ example.o zlib.a -g -lpthread
 
 minigzip: minigzip.o zlib.a
-	"$(CC)" $(CFLAGS) -o $@ minigzip.o zlib.a -g
+	"$(CC)" $(CFLAGS) -o $@ minigzip.o zlib.a -g -lpthread
+
+zbench: zbench.o zlib.a
+	"$(CC)" $(CFLAGS) -o $@ zbench.o zlib.a -lpthread
+
+# speed and ratio of each level and strategy, as JSON; add BENCHFLAGS="file ..."
+# to measure on a corpus of your own instead of the generated one
+BENCHFLAGS=
+BENCHOUT=bench.json
+
+bench: zbench
+	./zbench $(BENCHFLAGS) > $(BENCHOUT)
 
 test: example minigzip
 	./example
 	echo hello world | minigzip | minigzip -d
 
 clean:
-	"$(RM)" $(OBJS) zlib.a example.o example minigzip minigzip.o test foo.gz
+	"$(RM)" $(OBJS) zlib.a example.o example minigzip minigzip.o test foo.gz \
+		zbench zbench.o bench.json
 
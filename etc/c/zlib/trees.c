@@ -80,8 +80,12 @@ local const uch bl_order[BL_CODES]
 
 #define DIST_CODE_LEN  512 /* see definition of array dist_code below */
 
-#if defined(GEN_TREES_H) || !defined(STDC)
-/* non ANSI compilers may not accept trees.h */
+#ifdef GEN_TREES_H
+/* The tables are computed by tr_static_init() only to write out trees.h.
+ * Otherwise they are the constant ones in trees.h, so that nothing needs to
+ * be set up on the first use, and the first uses from several threads are
+ * safe.
+ */
 
 local ct_data static_ltree[L_CODES+2];
 /* The static literal tree. Since the bit lengths are imposed, there is no
@@ -135,7 +139,9 @@ local const static_tree_desc  static_bl_desc =
  * Local (static) routines in this file.
  */
 
+#ifdef GEN_TREES_H
 local void tr_static_init OF((void));
+#endif
 local void init_block     OF((deflate_state *s));
 local void pqdownheap     OF((deflate_state *s, ct_data *tree, int k));
 local void gen_bitlen     OF((deflate_state *s, tree_desc *desc));
@@ -177,32 +183,63 @@ local void gen_trees_header OF((void));
 }
 
 /* ===========================================================================
- * Send a value on a given number of bits.
- * IN assertion: length <= 16 and value fits in length bits.
+ * Output a full bit buffer LSB first on the stream.  With DEFLATE_BITS64 this
+ * is one eight-byte store where the byte order allows it.
+ * IN assertion: there is enough room in pendingBuf.
+ */
+#ifdef DEFLATE_BITS64
+#  if defined(__x86_64__) || defined(_M_X64) || defined(_M_ARM64) || \
+      (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#    define put_bi_buf(s, w) { \
+         bi_t put_w = (w); \
+         zmemcpy(s->pending_buf + s->pending, (Bytef *)&put_w, 8); \
+         s->pending += 8; \
+     }
+#  else
+#    define put_bi_buf(s, w) { \
+         put_short(s, (w)); \
+         put_short(s, (w) >> 16); \
+         put_short(s, (w) >> 32); \
+         put_short(s, (w) >> 48); \
+     }
+#  endif
+#  define MAX_SEND_BITS 48
+#else
+#  define put_bi_buf(s, w) put_short(s, w)
+#  define MAX_SEND_BITS 15
+#endif
+/* MAX_SEND_BITS is the longest value send_bits() takes at once.  The 64-bit
+ * buffer takes a whole length/distance pair with its extra bits.
+ */
+
+/* ===========================================================================
+ * Send a value on a given number of bits.  The bit buffer is emptied when it
+ * would become full, so bi_valid stays below Buf_size.
+ * IN assertion: length <= MAX_SEND_BITS and value fits in length bits.
  */
 #ifdef ZLIB_DEBUG
-local void send_bits      OF((deflate_state *s, int value, int length));
+local void send_bits      OF((deflate_state *s, bi_t value, int length));
 
 local void send_bits(s, value, length)
     deflate_state *s;
-    int value;  /* value to send */
+    bi_t value; /* value to send */
     int length; /* number of bits */
 {
-    Tracevv((stderr," l %2d v %4x ", length, value));
-    Assert(length > 0 && length <= 15, "invalid length");
+    Tracevv((stderr," l %2d v %4lx ", length, (unsigned long)value));
+    Assert(length > 0 && length <= MAX_SEND_BITS, "invalid length");
     s->bits_sent += (ulg)length;
 
     /* If not enough room in bi_buf, use (valid) bits from bi_buf and
-     * (16 - bi_valid) bits from value, leaving (width - (16-bi_valid))
-     * unused bits in value.
+     * (Buf_size - bi_valid) bits from value, leaving
+     * (width - (Buf_size - bi_valid)) unused bits in value.
      */
-    if (s->bi_valid > (int)Buf_size - length) {
-        s->bi_buf |= (ush)value << s->bi_valid;
-        put_short(s, s->bi_buf);
-        s->bi_buf = (ush)value >> (Buf_size - s->bi_valid);
+    if (s->bi_valid >= (int)Buf_size - length) {
+        s->bi_buf |= value << s->bi_valid;
+        put_bi_buf(s, s->bi_buf);
+        s->bi_buf = value >> (Buf_size - s->bi_valid);
         s->bi_valid += length - Buf_size;
     } else {
-        s->bi_buf |= (ush)value << s->bi_valid;
+        s->bi_buf |= value << s->bi_valid;
         s->bi_valid += length;
     }
 }
@@ -210,28 +247,55 @@ local void send_bits(s, value, length)
 
 #define send_bits(s, value, length) \
 { int len = length;\
-  if (s->bi_valid > (int)Buf_size - len) {\
-    int val = (int)value;\
-    s->bi_buf |= (ush)val << s->bi_valid;\
-    put_short(s, s->bi_buf);\
-    s->bi_buf = (ush)val >> (Buf_size - s->bi_valid);\
+  if (s->bi_valid >= (int)Buf_size - len) {\
+    bi_t val = (bi_t)(value);\
+    s->bi_buf |= val << s->bi_valid;\
+    put_bi_buf(s, s->bi_buf);\
+    s->bi_buf = val >> (Buf_size - s->bi_valid);\
     s->bi_valid += len - Buf_size;\
   } else {\
-    s->bi_buf |= (ush)(value) << s->bi_valid;\
+    s->bi_buf |= (bi_t)(value) << s->bi_valid;\
     s->bi_valid += len;\
   }\
 }
 #endif /* ZLIB_DEBUG */
 
 
+#ifdef DEFLATE_BITS64
+/* ===========================================================================
+ * Send a match as one value of at most 48 bits: the length code, the extra
+ * length bits, the distance code and the extra distance bits.  dist is the
+ * match distance and lc the match length - MIN_MATCH.  Both are modified.
+ */
+#define send_match(s, dist, lc, ltree, dtree) { \
+    unsigned m_code = _length_code[lc]; \
+    int m_len = ltree[m_code+LITERALS+1].Len; \
+    bi_t m_bits = ltree[m_code+LITERALS+1].Code; \
+    int m_extra = extra_lbits[m_code]; \
+    if (m_extra != 0) { \
+        m_bits |= (bi_t)(lc - base_length[m_code]) << m_len; \
+        m_len += m_extra; \
+    } \
+    dist--; \
+    m_code = d_code(dist); \
+    Assert (m_code < D_CODES, "bad d_code"); \
+    m_bits |= (bi_t)dtree[m_code].Code << m_len; \
+    m_len += dtree[m_code].Len; \
+    m_extra = extra_dbits[m_code]; \
+    m_bits |= (bi_t)(dist - (unsigned)base_dist[m_code]) << m_len; \
+    m_len += m_extra; \
+    send_bits(s, m_bits, m_len); \
+}
+#endif
+
 /* the arguments must not have side effects */
 
 /* ===========================================================================
  * Initialize the various 'constant' tables.
  */
+#ifdef GEN_TREES_H
 local void tr_static_init()
 {
-#if defined(GEN_TREES_H) || !defined(STDC)
     static int static_init_done = 0;
     int n;        /* iterates over tree elements */
     int bits;     /* bit counter */
@@ -305,11 +369,9 @@ local void tr_static_init()
     }
     static_init_done = 1;
 
-#  ifdef GEN_TREES_H
     gen_trees_header();
-#  endif
-#endif /* defined(GEN_TREES_H) || !defined(STDC) */
 }
+#endif /* GEN_TREES_H */
 
 /* ===========================================================================
  * Genererate the file trees.h describing the static trees.
@@ -332,38 +394,43 @@ void gen_trees_header()
     fprintf(header,
             "/* header created automatically with -DGEN_TREES_H */\n\n");
 
-    fprintf(header, "local const ct_data static_ltree[L_CODES+2] = {\n");
+    fprintf(header, "Z_ALIGNED(Z_CACHELINE) "
+                    "local const ct_data static_ltree[L_CODES+2] = {\n");
     for (i = 0; i < L_CODES+2; i++) {
         fprintf(header, "{{%3u},{%3u}}%s", static_ltree[i].Code,
                 static_ltree[i].Len, SEPARATOR(i, L_CODES+1, 5));
     }
 
-    fprintf(header, "local const ct_data static_dtree[D_CODES] = {\n");
+    fprintf(header, "Z_ALIGNED(Z_CACHELINE) "
+                    "local const ct_data static_dtree[D_CODES] = {\n");
     for (i = 0; i < D_CODES; i++) {
         fprintf(header, "{{%2u},{%2u}}%s", static_dtree[i].Code,
                 static_dtree[i].Len, SEPARATOR(i, D_CODES-1, 5));
     }
 
-    fprintf(header, "const uch ZLIB_INTERNAL _dist_code[DIST_CODE_LEN] = {\n");
+    fprintf(header, "Z_ALIGNED(Z_CACHELINE) "
+                    "const uch ZLIB_INTERNAL _dist_code[DIST_CODE_LEN] = {\n");
     for (i = 0; i < DIST_CODE_LEN; i++) {
         fprintf(header, "%2u%s", _dist_code[i],
                 SEPARATOR(i, DIST_CODE_LEN-1, 20));
     }
 
-    fprintf(header,
+    fprintf(header, "Z_ALIGNED(Z_CACHELINE) "
         "const uch ZLIB_INTERNAL _length_code[MAX_MATCH-MIN_MATCH+1]= {\n");
     for (i = 0; i < MAX_MATCH-MIN_MATCH+1; i++) {
         fprintf(header, "%2u%s", _length_code[i],
                 SEPARATOR(i, MAX_MATCH-MIN_MATCH, 20));
     }
 
-    fprintf(header, "local const int base_length[LENGTH_CODES] = {\n");
+    fprintf(header, "Z_ALIGNED(Z_CACHELINE) "
+                    "local const int base_length[LENGTH_CODES] = {\n");
     for (i = 0; i < LENGTH_CODES; i++) {
         fprintf(header, "%1u%s", base_length[i],
                 SEPARATOR(i, LENGTH_CODES-1, 20));
     }
 
-    fprintf(header, "local const int base_dist[D_CODES] = {\n");
+    fprintf(header, "Z_ALIGNED(Z_CACHELINE) "
+                    "local const int base_dist[D_CODES] = {\n");
     for (i = 0; i < D_CODES; i++) {
         fprintf(header, "%5u%s", base_dist[i],
                 SEPARATOR(i, D_CODES-1, 10));
@@ -379,7 +446,9 @@ void gen_trees_header()
 void ZLIB_INTERNAL _tr_init(s)
     deflate_state *s;
 {
+#ifdef GEN_TREES_H
     tr_static_init();
+#endif
 
     s->l_desc.dyn_tree = s->dyn_ltree;
     s->l_desc.stat_desc = &static_l_desc;
@@ -872,6 +941,7 @@ void ZLIB_INTERNAL _tr_stored_block(s, buf, stored_len, last)
     put_short(s, (ush)~stored_len);
     zmemcpy(s->pending_buf + s->pending, (Bytef *)buf, stored_len);
     s->pending += stored_len;
+    DSTAT(s, stored_blocks, 1);
 #ifdef ZLIB_DEBUG
     s->compressed_len = (s->compressed_len + 3 + 7) & (ulg)~7L;
     s->compressed_len += (stored_len + 4) << 3;
@@ -904,6 +974,73 @@ void ZLIB_INTERNAL _tr_align(s)
     bi_flush(s);
 }
 
+/* ===========================================================================
+ * Send fixed code blocks one symbol at a time, for deflate_quick().  This
+ * skips the symbol buffer and the tree construction, since there is nothing
+ * to choose.  _tr_fixed_start() sends the block header, _tr_fixed_lit() a
+ * literal byte, _tr_fixed_dist() a match with length lc + MIN_MATCH, and
+ * _tr_fixed_end() the end of block code.  Each symbol takes at most 31 bits.
+ */
+void ZLIB_INTERNAL _tr_fixed_start(s, last)
+    deflate_state *s;
+    int last;         /* one if this is the last block for a file */
+{
+    send_bits(s, (STATIC_TREES<<1)+last, 3);
+    DSTAT(s, fixed_blocks, 1);
+}
+
+void ZLIB_INTERNAL _tr_fixed_lit(s, c)
+    deflate_state *s;
+    unsigned c;       /* literal byte */
+{
+    send_code(s, c, static_ltree);
+    Tracecv(isgraph(c), (stderr," '%c' ", c));
+    DSTAT(s, literals, 1);
+}
+
+void ZLIB_INTERNAL _tr_fixed_dist(s, dist, lc)
+    deflate_state *s;
+    unsigned dist;    /* distance of matched string */
+    unsigned lc;      /* match length-MIN_MATCH */
+{
+#ifdef DEFLATE_BITS64
+    send_match(s, dist, lc, static_ltree, static_dtree);
+#else
+    unsigned code;    /* the code to send */
+    int extra;        /* number of extra bits to send */
+
+    code = _length_code[lc];
+    send_code(s, code+LITERALS+1, static_ltree);
+    extra = extra_lbits[code];
+    if (extra != 0) {
+        lc -= base_length[code];
+        send_bits(s, lc, extra);
+    }
+    dist--;
+    code = d_code(dist);
+    Assert (code < D_CODES, "bad d_code");
+    send_code(s, code, static_dtree);
+    extra = extra_dbits[code];
+    if (extra != 0) {
+        dist -= (unsigned)base_dist[code];
+        send_bits(s, dist, extra);
+    }
+#endif
+    DSTAT(s, matches, 1);
+}
+
+void ZLIB_INTERNAL _tr_fixed_end(s, last)
+    deflate_state *s;
+    int last;         /* one if this is the last block for a file */
+{
+    send_code(s, END_BLOCK, static_ltree);
+    if (last)
+        bi_windup(s);
+#ifdef ZLIB_DEBUG
+    s->compressed_len = s->bits_sent;
+#endif
+}
+
 /* ===========================================================================
  * Determine the best encoding for the current block: dynamic trees, static
  * trees or store, and write out the encoded block.
@@ -951,6 +1088,14 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
 
         if (static_lenb <= opt_lenb) opt_lenb = static_lenb;
 
+        /* For Z_ADAPTIVE, have deflate() store what follows a large block
+         * that hardly compressed.
+         */
+        if (s->strategy == Z_ADAPTIVE && !last && buf != (charf *)0 &&
+            stored_len >= PASSTHROUGH_MIN &&
+            opt_lenb + (stored_len >> PASSTHROUGH_GAIN) >= stored_len)
+            s->passthrough = 1;
+
     } else {
         Assert(buf != (char*)0, "lost buf");
         opt_lenb = static_lenb = stored_len + 5; /* force a stored block */
@@ -978,6 +1123,7 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
         send_bits(s, (STATIC_TREES<<1)+last, 3);
         compress_block(s, (const ct_data *)static_ltree,
                        (const ct_data *)static_dtree);
+        DSTAT(s, fixed_blocks, 1);
 #ifdef ZLIB_DEBUG
         s->compressed_len += 3 + s->static_len;
 #endif
@@ -987,6 +1133,7 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
                        max_blindex+1);
         compress_block(s, (const ct_data *)s->dyn_ltree,
                        (const ct_data *)s->dyn_dtree);
+        DSTAT(s, dynamic_blocks, 1);
 #ifdef ZLIB_DEBUG
         s->compressed_len += 3 + s->opt_len;
 #endif
@@ -1021,8 +1168,10 @@ int ZLIB_INTERNAL _tr_tally (s, dist, lc)
     if (dist == 0) {
         /* lc is the unmatched char */
         s->dyn_ltree[lc].Freq++;
+        DSTAT(s, literals, 1);
     } else {
         s->matches++;
+        DSTAT(s, matches, 1);
         /* Here, lc is the match length - MIN_MATCH */
         dist--;             /* dist = match distance - 1 */
         Assert((ush)dist < (ush)MAX_DIST(s) &&
@@ -1069,8 +1218,10 @@ local void compress_block(s, ltree, dtree)
     unsigned dist;      /* distance of matched string */
     int lc;             /* match length or unmatched char (if dist == 0) */
     unsigned lx = 0;    /* running index in l_buf */
+#ifndef DEFLATE_BITS64
     unsigned code;      /* the code to send */
     int extra;          /* number of extra bits to send */
+#endif
 
     if (s->last_lit != 0) do {
         dist = s->d_buf[lx];
@@ -1079,6 +1230,9 @@ local void compress_block(s, ltree, dtree)
             send_code(s, lc, ltree); /* send a literal byte */
             Tracecv(isgraph(lc), (stderr," '%c' ", lc));
         } else {
+#ifdef DEFLATE_BITS64
+            send_match(s, dist, lc, ltree, dtree);
+#else
             /* Here, lc is the match length - MIN_MATCH */
             code = _length_code[lc];
             send_code(s, code+LITERALS+1, ltree); /* send the length code */
@@ -1097,6 +1251,7 @@ local void compress_block(s, ltree, dtree)
                 dist -= (unsigned)base_dist[code];
                 send_bits(s, dist, extra);   /* send the extra distance bits */
             }
+#endif
         } /* literal or match pair ? */
 
         /* Check that the overlay between pending_buf and d_buf+l_buf is ok: */
@@ -1173,6 +1328,13 @@ local unsigned bi_reverse(code, len)
 local void bi_flush(s)
     deflate_state *s;
 {
+#ifdef DEFLATE_BITS64
+    while (s->bi_valid >= 8) {
+        put_byte(s, (Byte)s->bi_buf);
+        s->bi_buf >>= 8;
+        s->bi_valid -= 8;
+    }
+#else
     if (s->bi_valid == 16) {
         put_short(s, s->bi_buf);
         s->bi_buf = 0;
@@ -1182,6 +1344,7 @@ local void bi_flush(s)
         s->bi_buf >>= 8;
         s->bi_valid -= 8;
     }
+#endif
 }
 
 /* ===========================================================================
@@ -1190,11 +1353,19 @@ local void bi_flush(s)
 local void bi_windup(s)
     deflate_state *s;
 {
+#ifdef DEFLATE_BITS64
+    while (s->bi_valid > 0) {
+        put_byte(s, (Byte)s->bi_buf);
+        s->bi_buf >>= 8;
+        s->bi_valid -= 8;
+    }
+#else
     if (s->bi_valid > 8) {
         put_short(s, s->bi_buf);
     } else if (s->bi_valid > 0) {
         put_byte(s, (Byte)s->bi_buf);
     }
+#endif
     s->bi_buf = 0;
     s->bi_valid = 0;
 #ifdef ZLIB_DEBUG
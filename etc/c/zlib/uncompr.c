@@ -67,7 +67,9 @@ int ZEXPORT uncompress2 (dest, destLen, source, sourceLen)
             stream.avail_in = len > (uLong)max ? max : (uInt)len;
             len -= stream.avail_in;
         }
-        err = inflate(&stream, Z_NO_FLUSH);
+        /* with all of the input and output given, Z_FINISH decodes in one go
+           without allocating or updating a sliding window */
+        err = inflate(&stream, len == 0 && left == 0 ? Z_FINISH : Z_NO_FLUSH);
     } while (err == Z_OK);
 
     *sourceLen -= len + stream.avail_in;
@@ -15,6 +15,12 @@ O=.obj
 # do not preselect a C runtime (extracted from the line above to make the auto tester happy)
 CFLAGS=$(CFLAGS) /Zl /GS-
 
+# use the 64-bit bit buffers in inflate_fast() and deflate (ignored for 32-bit)
+CFLAGS=$(CFLAGS) /DINFLATE_FAST64 /DDEFLATE_BITS64
+
+# use the larger inflate root tables with literal pairs
+CFLAGS=$(CFLAGS) /DINFLATE_WIDE_TABLES
+
 # variables
 
 OBJS = adler32$(O) compress$(O) crc32$(O) deflate$(O) gzclose$(O) gzlib$(O) gzread$(O) \
@@ -0,0 +1,570 @@
+/* zbench.c -- speed and ratio benchmark for the compression library
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* zbench measures, for each compression level 0..9 and each strategy, the
+ * compression and decompression speed and the compression ratio, and the
+ * speed of adler32() and crc32(), on a corpus.  Z_QUICK and Z_MEDIUM ignore
+ * the level, so they are only measured at level 1, and Z_ADAPTIVE, which only
+ * differs on incompressible data, at level 6.  The results are written to
+ * stdout as a JSON object, so that runs of different versions or builds can
+ * be compared by a script.
+ *
+ * usage: zbench [-t seconds] [-s size] [file ...]
+ *
+ * Without files, a corpus of three generated inputs is used: English-like
+ * text, JSON log lines and binary records.  These are made by a fixed
+ * pseudo-random sequence, so they are the same on every run and platform.
+ * -s sets the size of each generated input (default 2 MiB), and -t the
+ * minimum time spent on each measurement (default 0.2 seconds).
+ */
+
+#include "zlib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+
+#ifndef local
+#  define local static
+#endif
+
+typedef struct {
+    char *name;
+    unsigned char *data;
+    unsigned long size;
+} input;
+
+local double now OF((void));
+local unsigned long rnd OF((void));
+local void put OF((input *, const char *, unsigned long));
+local void repeat OF((input *));
+local input gen_text OF((unsigned long));
+local input gen_json OF((unsigned long));
+local input gen_binary OF((unsigned long));
+local int load OF((input *, const char *));
+local void json_string OF((const char *));
+local const char *strategy_name OF((int));
+local void bench OF((input *, int, int, double, int));
+local void bench_check OF((input *, double, int));
+local void bail OF((const char *, const char *));
+int main OF((int, char **));
+
+/* ===========================================================================
+ * Return the time in seconds from an arbitrary starting point.
+ */
+local double now()
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+}
+
+/* ===========================================================================
+ * Fixed pseudo-random sequence, so that the generated corpus does not depend
+ * on the C library.
+ */
+local unsigned long seed = 1;
+
+local unsigned long rnd()
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return seed >> 8;
+}
+
+/* ===========================================================================
+ * Append len bytes of str to in, without going past the size being generated.
+ */
+local unsigned long gen_limit;
+
+local void put(in, str, len)
+    input *in;
+    const char *str;
+    unsigned long len;
+{
+    if (len > gen_limit - in->size)
+        len = gen_limit - in->size;
+    memcpy(in->data + in->size, str, len);
+    in->size += len;
+}
+
+/* ===========================================================================
+ * Append a copy of a random piece of the last 30000 bytes of in, as real data
+ * repeats phrases and code sequences.
+ */
+local void repeat(in)
+    input *in;
+{
+    unsigned long dist, len;
+
+    if (in->size < 100)
+        return;
+    dist = 1 + rnd() % (in->size < 30000 ? in->size : 30000);
+    len = 8 + rnd() % 56;
+    if (len > dist)
+        len = dist;
+    put(in, (const char *)in->data + in->size - dist, len);
+}
+
+local const char *words[] = {
+    "the", "of", "and", "to", "a", "in", "is", "that", "for", "it", "as",
+    "was", "with", "be", "by", "on", "not", "he", "this", "are", "or", "his",
+    "from", "at", "which", "but", "have", "an", "they", "you", "were", "her",
+    "all", "she", "there", "would", "their", "we", "him", "been", "has",
+    "when", "who", "will", "more", "no", "if", "out", "so", "said", "what",
+    "up", "its", "about", "into", "than", "them", "can", "only", "other",
+    "new", "some", "could", "time", "these", "two", "may", "then", "do",
+    "first", "any", "my", "now", "such", "like", "our", "over", "man", "me",
+    "even", "most", "made", "after", "also", "did", "many", "before", "must",
+    "through", "back", "years", "where", "much", "your", "way", "well",
+    "down", "should", "because", "each", "just", "those", "people", "how",
+    "too", "little", "state", "good", "very", "make", "world", "still",
+    "own", "see", "men", "work", "long", "get", "here", "between", "both",
+    "life", "being", "under", "never", "day", "same", "another", "know",
+    "while", "last", "might", "us", "great", "old", "year", "off", "come",
+    "since", "against", "go", "came", "right", "used", "take", "three",
+    "compression", "library", "window", "stream", "buffer", "dictionary",
+    "algorithm", "deflate", "inflate", "Huffman", "literal", "distance"
+};
+
+#define WORDS (sizeof(words) / sizeof(words[0]))
+
+/* ===========================================================================
+ * Generate size bytes of text made of sentences of common English words,
+ * with word frequencies falling off roughly as in natural language.
+ */
+local input gen_text(size)
+    unsigned long size;
+{
+    input in;
+    unsigned long col = 0, n;
+    int start = 1;
+    unsigned long r;
+    const char *w;
+    char cap[32];
+
+    in.name = "text";
+    in.data = malloc(size ? size : 1);
+    in.size = 0;
+    if (in.data == NULL)
+        bail("out of memory", "");
+    gen_limit = size;
+    while (in.size < size) {
+        if (rnd() % 6 == 0) {
+            repeat(&in);
+            col += 32;
+        }
+        r = rnd() % 3 ? 40 : WORDS;     /* mostly the common words */
+        w = words[rnd() % r];
+        n = strlen(w);
+        if (start) {
+            memcpy(cap, w, n);
+            if (cap[0] >= 'a' && cap[0] <= 'z')
+                cap[0] -= 'a' - 'A';
+            w = cap;
+            start = 0;
+        }
+        put(&in, w, n);
+        col += n;
+        if (rnd() % 12 == 0) {
+            put(&in, rnd() % 4 ? "." : ",", 1);
+            start = in.data[in.size - 1] == '.';
+            col++;
+        }
+        if (col > 70) {
+            put(&in, "\n", 1);
+            col = 0;
+        }
+        else {
+            put(&in, " ", 1);
+            col++;
+        }
+    }
+    return in;
+}
+
+/* ===========================================================================
+ * Generate size bytes of JSON log records, one per line, as written by a
+ * typical web service.
+ */
+local input gen_json(size)
+    unsigned long size;
+{
+    static const char *levels[] = {"info", "info", "info", "debug", "warn",
+                                   "error"};
+    static const char *paths[] = {"/v1/items", "/v1/users", "/v1/orders",
+                                  "/health", "/v2/search", "/static/app.js"};
+    static const int codes[] = {200, 200, 200, 200, 201, 204, 304, 404, 500};
+    input in;
+    unsigned long t = 1700000000UL, req = 100000;
+    unsigned long v[12];
+    char line[512];
+    int len, i;
+
+    in.name = "json";
+    in.data = malloc(size ? size : 1);
+    in.size = 0;
+    if (in.data == NULL)
+        bail("out of memory", "");
+    gen_limit = size;
+    while (in.size < size) {
+        t += rnd() % 3;
+        for (i = 0; i < 12; i++)        /* in a fixed order */
+            v[i] = rnd();
+        len = sprintf(line,
+            "{\"ts\":\"%lu.%03lu\",\"level\":\"%s\",\"service\":\"api-%lu\","
+            "\"request\":%lu,\"method\":\"%s\",\"path\":\"%s/%lu\","
+            "\"status\":%d,\"ms\":%lu.%lu,\"bytes\":%lu,"
+            "\"agent\":\"client/%lu.%lu\"}\n",
+            t, v[0] % 1000, levels[v[1] % 6], v[2] % 4, req++,
+            v[3] % 5 ? "GET" : "POST", paths[v[4] % 6], v[5] % 5000,
+            codes[v[6] % 9], v[7] % 200, v[8] % 10, v[9] % 100000,
+            1 + v[10] % 3, v[11] % 10);
+        put(&in, line, (unsigned long)len);
+    }
+    return in;
+}
+
+/* ===========================================================================
+ * Generate size bytes of binary data: records of small integers, increasing
+ * offsets, floating point values and some random bytes, as found in object
+ * files and databases.
+ */
+local input gen_binary(size)
+    unsigned long size;
+{
+    input in;
+    unsigned long off = 0x400000UL, v;
+    unsigned char rec[32];
+    int i, n;
+
+    in.name = "binary";
+    in.data = malloc(size ? size : 1);
+    in.size = 0;
+    if (in.data == NULL)
+        bail("out of memory", "");
+    gen_limit = size;
+    while (in.size < size) {
+        n = 0;
+        if (rnd() % 4 == 0)
+            repeat(&in);
+        switch (rnd() % 8) {
+        case 0: case 1: case 2: /* opcode-like bytes from a skewed set */
+            for (i = 0; i < 12; i++) {
+                v = 1 + rnd() % 256;
+                rec[n++] = (unsigned char)(rnd() % v);
+            }
+            break;
+        case 3: case 4:     /* increasing little-endian offset */
+            off += rnd() % 64;
+            for (i = 0; i < 4; i++)
+                rec[n++] = (unsigned char)(off >> (8 * i));
+            rec[n++] = 0;
+            rec[n++] = 0;
+            rec[n++] = 0;
+            rec[n++] = 0;
+            break;
+        case 5:             /* small counts */
+            v = rnd() % 16;
+            rec[n++] = (unsigned char)v;
+            rec[n++] = 0;
+            rec[n++] = (unsigned char)(rnd() % 3);
+            rec[n++] = 0;
+            break;
+        case 6:             /* float-like: few random bits, common exponent */
+            for (i = 0; i < 4; i++)
+                rec[n++] = 0;
+            rec[n++] = (unsigned char)rnd();
+            rec[n++] = (unsigned char)(rnd() & 0xf0);
+            rec[n++] = (unsigned char)(0xf0 | (rnd() % 16));
+            rec[n++] = 0x3f;
+            break;
+        default:            /* noise */
+            for (i = 0; i < 4; i++)
+                rec[n++] = (unsigned char)rnd();
+        }
+        put(&in, (const char *)rec, (unsigned long)n);
+    }
+    return in;
+}
+
+/* ===========================================================================
+ * Read the file path into in.  Return 0 on success, -1 on error.
+ */
+local int load(in, path)
+    input *in;
+    const char *path;
+{
+    FILE *f;
+    long len;
+    size_t got;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+        return -1;
+    if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) < 0 ||
+        fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return -1;
+    }
+    in->data = malloc(len ? (size_t)len : 1);
+    if (in->data == NULL) {
+        fclose(f);
+        return -1;
+    }
+    got = fread(in->data, 1, (size_t)len, f);
+    fclose(f);
+    if (got != (size_t)len) {
+        free(in->data);
+        return -1;
+    }
+    in->name = (char *)path;
+    in->size = (unsigned long)len;
+    return 0;
+}
+
+/* ===========================================================================
+ * Write str as a JSON string.
+ */
+local void json_string(str)
+    const char *str;
+{
+    putchar('"');
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            printf("\\%c", *str);
+        else if ((unsigned char)*str < 0x20)
+            printf("\\u%04x", (unsigned char)*str);
+        else
+            putchar(*str);
+    }
+    putchar('"');
+}
+
+local const char *strategy_name(strategy)
+    int strategy;
+{
+    switch (strategy) {
+    case Z_FILTERED:        return "filtered";
+    case Z_HUFFMAN_ONLY:    return "huffman_only";
+    case Z_RLE:             return "rle";
+    case Z_QUICK:           return "quick";
+    case Z_MEDIUM:          return "medium";
+    case Z_ADAPTIVE:        return "adaptive";
+    default:                return "default";
+    }
+}
+
+/* ===========================================================================
+ * Measure compression with level and strategy and decompression of the
+ * result, each for at least mintime seconds, and write the JSON object for
+ * the results.
+ */
+local void bench(in, level, strategy, mintime, first)
+    input *in;
+    int level, strategy;
+    double mintime;
+    int first;
+{
+    z_stream strm;
+    unsigned char *comp, *back;
+    uLong bound, clen = 0;
+    double start, ctime, dtime;
+    long cruns, druns;
+    int ret;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    if (deflateInit2(&strm, level, Z_DEFLATED, 15, 8, strategy) != Z_OK)
+        bail("deflateInit2 failed", "");
+
+    /* compressBound() is too small for Z_QUICK on incompressible data */
+    bound = deflateBound(&strm, in->size);
+    comp = malloc(bound);
+    back = malloc(in->size ? in->size : 1);
+    if (comp == NULL || back == NULL)
+        bail("out of memory", "");
+    cruns = 0;
+    start = now();
+    do {
+        deflateReset(&strm);
+        strm.next_in = in->data;
+        strm.avail_in = (uInt)in->size;
+        strm.next_out = comp;
+        strm.avail_out = (uInt)bound;
+        ret = deflate(&strm, Z_FINISH);
+        if (ret != Z_STREAM_END)
+            bail("deflate failed on ", in->name);
+        clen = strm.total_out;
+        cruns++;
+        ctime = now() - start;
+    } while (ctime < mintime);
+    deflateEnd(&strm);
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.next_in = Z_NULL;
+    strm.avail_in = 0;
+    if (inflateInit(&strm) != Z_OK)
+        bail("inflateInit failed", "");
+    druns = 0;
+    start = now();
+    do {
+        inflateReset(&strm);
+        strm.next_in = comp;
+        strm.avail_in = (uInt)clen;
+        strm.next_out = back;
+        strm.avail_out = (uInt)in->size;
+        ret = inflate(&strm, Z_FINISH);
+        if (ret != Z_STREAM_END || strm.total_out != in->size)
+            bail("inflate failed on ", in->name);
+        druns++;
+        dtime = now() - start;
+    } while (dtime < mintime);
+    inflateEnd(&strm);
+    if (memcmp(back, in->data, in->size) != 0)
+        bail("round trip mismatch on ", in->name);
+
+    printf("%s\n    {\"input\": ", first ? "" : ",");
+    json_string(in->name);
+    printf(", \"level\": %d, \"strategy\": \"%s\", \"size\": %lu, "
+           "\"compressed\": %lu, \"ratio\": %.4f, "
+           "\"compress_mbs\": %.2f, \"decompress_mbs\": %.2f}",
+           level, strategy_name(strategy), in->size, clen,
+           in->size ? (double)clen / in->size : 1.0,
+           in->size * (double)cruns / ctime / 1e6,
+           in->size * (double)druns / dtime / 1e6);
+    fflush(stdout);
+    free(back);
+    free(comp);
+}
+
+/* ===========================================================================
+ * Measure adler32() and crc32() on in and write the JSON object.
+ */
+local void bench_check(in, mintime, first)
+    input *in;
+    double mintime;
+    int first;
+{
+    double start, atime, ctime;
+    long aruns, cruns;
+    uLong check;
+
+    aruns = 0;
+    start = now();
+    do {
+        check = adler32(0L, Z_NULL, 0);
+        check = adler32(check, in->data, (uInt)in->size);
+        aruns++;
+        atime = now() - start;
+    } while (atime < mintime);
+
+    cruns = 0;
+    start = now();
+    do {
+        check = crc32(0L, Z_NULL, 0);
+        check = crc32(check, in->data, (uInt)in->size);
+        cruns++;
+        ctime = now() - start;
+    } while (ctime < mintime);
+
+    printf("%s\n    {\"input\": ", first ? "" : ",");
+    json_string(in->name);
+    printf(", \"size\": %lu, \"adler32_mbs\": %.2f, \"crc32_mbs\": %.2f}",
+           in->size, in->size * (double)aruns / atime / 1e6,
+           in->size * (double)cruns / ctime / 1e6);
+    fflush(stdout);
+}
+
+/* ===========================================================================
+ * Display error message and exit
+ */
+local void bail(msg, arg)
+    const char *msg, *arg;
+{
+    fflush(stdout);
+    fprintf(stderr, "zbench: %s%s\n", msg, arg);
+    exit(1);
+}
+
+int main(argc, argv)
+    int argc;
+    char *argv[];
+{
+    static const int strategies[] = {Z_DEFAULT_STRATEGY, Z_FILTERED, Z_RLE,
+                                     Z_HUFFMAN_ONLY, Z_QUICK, Z_MEDIUM,
+                                     Z_ADAPTIVE};
+    input *inputs;
+    int count = 0, i, s, level, first;
+    double mintime = 0.2;
+    unsigned long size = 2UL << 20;
+
+    inputs = malloc((argc + 3) * sizeof(input));
+    if (inputs == NULL)
+        bail("out of memory", "");
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            mintime = atof(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            size = strtoul(argv[++i], NULL, 10);
+        else if (argv[i][0] == '-')
+            bail("usage: zbench [-t seconds] [-s size] [file ...]", "");
+        else if (load(&inputs[count++], argv[i]) != 0)
+            bail("can't read ", argv[i]);
+    }
+    if (size > 0x7fffffffUL)
+        bail("size too big", "");
+    if (count == 0) {
+        inputs[count++] = gen_text(size);
+        inputs[count++] = gen_json(size);
+        inputs[count++] = gen_binary(size);
+    }
+
+    printf("{\n  \"zlib\": \"%s\",\n  \"flags\": \"0x%lx\",\n  \"inputs\": [",
+           zlibVersion(), zlibCompileFlags());
+    for (i = 0; i < count; i++) {
+        printf("%s\n    {\"name\": ", i ? "," : "");
+        json_string(inputs[i].name);
+        printf(", \"size\": %lu, \"adler32\": \"%08lx\"}", inputs[i].size,
+               adler32(1L, inputs[i].data, (uInt)inputs[i].size));
+    }
+    printf("\n  ],\n  \"deflate\": [");
+    first = 1;
+    for (i = 0; i < count; i++)
+        for (s = 0; s < (int)(sizeof(strategies) / sizeof(strategies[0])); s++)
+            for (level = 0; level <= 9; level++) {
+                if ((strategies[s] == Z_QUICK || strategies[s] == Z_MEDIUM) &&
+                    level != 1)
+                    continue;
+                if (strategies[s] == Z_ADAPTIVE && level != 6)
+                    continue;
+                bench(&inputs[i], level, strategies[s], mintime, first);
+                first = 0;
+            }
+    printf("\n  ],\n  \"checksums\": [");
+    for (i = 0; i < count; i++)
+        bench_check(&inputs[i], mintime, i == 0);
+    printf("\n  ]\n}\n");
+
+    for (i = 0; i < count; i++)
+        free(inputs[i].data);
+    free(inputs);
+    return 0;
+}
@@ -34,6 +34,9 @@
 #    define compress              z_compress
 #    define compress2             z_compress2
 #    define compressBound         z_compressBound
+#    define deflateBatch          z_deflateBatch
+#    define deflateChunk          z_deflateChunk
+#    define deflateChunkBound     z_deflateChunkBound
 #  endif
 #  define crc32                 z_crc32
 #  define crc32_combine         z_crc32_combine
@@ -42,8 +45,11 @@
 #  define deflate               z_deflate
 #  define deflateBound          z_deflateBound
 #  define deflateCopy           z_deflateCopy
+#  define deflateCopyDictionary z_deflateCopyDictionary
 #  define deflateEnd            z_deflateEnd
+#  define deflateFork           z_deflateFork
 #  define deflateGetDictionary  z_deflateGetDictionary
+#  define deflateGetStats       z_deflateGetStats
 #  define deflateInit           z_deflateInit
 #  define deflateInit2          z_deflateInit2
 #  define deflateInit2_         z_deflateInit2_
@@ -61,8 +67,10 @@
 #  ifndef Z_SOLO
 #    define gz_error              z_gz_error
 #    define gz_intmax             z_gz_intmax
+#    define gz_jump               z_gz_jump
 #    define gz_strwinerror        z_gz_strwinerror
 #    define gzbuffer              z_gzbuffer
+#    define gzbuildindex          z_gzbuildindex
 #    define gzclearerr            z_gzclearerr
 #    define gzclose               z_gzclose
 #    define gzclose_r             z_gzclose_r
@@ -77,6 +85,7 @@
 #    define gzgetc                z_gzgetc
 #    define gzgetc_               z_gzgetc_
 #    define gzgets                z_gzgets
+#    define gzloadindex           z_gzloadindex
 #    define gzoffset              z_gzoffset
 #    define gzoffset64            z_gzoffset64
 #    define gzopen                z_gzopen
@@ -89,6 +98,7 @@
 #    define gzputs                z_gzputs
 #    define gzread                z_gzread
 #    define gzrewind              z_gzrewind
+#    define gzsaveindex           z_gzsaveindex
 #    define gzseek                z_gzseek
 #    define gzseek64              z_gzseek64
 #    define gzsetparams           z_gzsetparams
@@ -108,11 +118,13 @@
 #  define inflateEnd            z_inflateEnd
 #  define inflateGetDictionary  z_inflateGetDictionary
 #  define inflateGetHeader      z_inflateGetHeader
+#  define inflateGetStats       z_inflateGetStats
 #  define inflateInit           z_inflateInit
 #  define inflateInit2          z_inflateInit2
 #  define inflateInit2_         z_inflateInit2_
 #  define inflateInit_          z_inflateInit_
 #  define inflateMark           z_inflateMark
+#  define inflateNoWindow       z_inflateNoWindow
 #  define inflatePrime          z_inflatePrime
 #  define inflateReset          z_inflateReset
 #  define inflateReset2         z_inflateReset2
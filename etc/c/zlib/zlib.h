@@ -130,6 +130,30 @@ typedef struct gz_header_s {
 
 typedef gz_header FAR *gz_headerp;
 
+/*
+     Per-stream counters returned by deflateGetStats() and inflateGetStats().
+  They are only maintained when zlib is compiled with ZLIB_STATS defined.
+*/
+typedef struct z_deflate_stats_s {
+    uLong   match_calls;    /* calls of longest_match() */
+    uLong   chain_steps;    /* hash chain entries examined by longest_match() */
+    uLong   matches;        /* length/distance pairs emitted */
+    uLong   literals;       /* literal bytes emitted */
+    uLong   stored_blocks;  /* stored blocks emitted */
+    uLong   fixed_blocks;   /* blocks emitted with the fixed codes */
+    uLong   dynamic_blocks; /* blocks emitted with dynamic codes */
+    uLong   slides;         /* times the window was slid down */
+} z_deflate_stats;
+
+typedef struct z_inflate_stats_s {
+    uLong   fast_calls;     /* calls of inflate_fast() */
+    uLong   fast_out;       /* bytes written by inflate_fast() */
+    uLong   slow_out;       /* bytes written by the inflate() state machine */
+    uLong   stored_blocks;  /* stored blocks decoded */
+    uLong   fixed_blocks;   /* blocks decoded with the fixed codes */
+    uLong   dynamic_blocks; /* blocks decoded with dynamic codes */
+} z_inflate_stats;
+
 /*
      The application must update next_in and avail_in when avail_in has dropped
    to zero.  It must update next_out and avail_out when avail_out has dropped
@@ -197,6 +221,9 @@ typedef gz_header FAR *gz_headerp;
 #define Z_HUFFMAN_ONLY        2
 #define Z_RLE                 3
 #define Z_FIXED               4
+#define Z_QUICK               5
+#define Z_MEDIUM              6
+#define Z_ADAPTIVE            7
 #define Z_DEFAULT_STRATEGY    0
 /* compression strategy; see deflateInit2() below for details */
 
@@ -600,6 +627,24 @@ ZEXTERN int ZEXPORT deflateInit2 OF((z_streamp strm,
    Z_FIXED prevents the use of dynamic Huffman codes, allowing for a simpler
    decoder for special applications.
 
+     Z_QUICK and Z_MEDIUM select their own search parameters and ignore level,
+   except that level 0 still stores.  Z_QUICK is for throughput: it probes a
+   single hash entry for each string, never defers a match, and writes fixed
+   code blocks as it goes, without buffering the block or building trees.  It
+   is faster than level 1 but compresses less, and incompressible data grows
+   by up to one eighth.  Z_MEDIUM does the lazy evaluation of levels 4..9
+   with short hash chains, and like levels 1..3 does not insert the strings
+   of long matches in the hash table.  It compresses about as well as level 5
+   in less time.  If zlib is compiled with FASTEST, both are the same as
+   Z_DEFAULT_STRATEGY.
+
+     Z_ADAPTIVE compresses as Z_DEFAULT_STRATEGY does at the given level, but
+   when a block of 8K or more shrinks by less than 1/32, the input that follows
+   is written as stored blocks, copied straight to next_out where there is
+   room, until 1M has been stored and a block is compressed again to check.
+   Data that is already compressed, such as images or archives, then costs
+   little more than a copy, and grows by at most 1/32.
+
      deflateInit2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
    memory, Z_STREAM_ERROR if any parameter is invalid (such as an invalid
    method), or Z_VERSION_ERROR if the zlib library version (zlib_version) is
@@ -674,6 +719,26 @@ ZEXTERN int ZEXPORT deflateGetDictionary OF((z_streamp strm,
    stream state is inconsistent.
 */
 
+ZEXTERN int ZEXPORT deflateCopyDictionary OF((z_streamp dest,
+                                              z_streamp source));
+/*
+     Resets dest and then loads it with the dictionary that was given to source
+   with deflateSetDictionary(), exactly as if deflateSetDictionary() had been
+   called on dest with the same dictionary.  Instead of hashing the dictionary
+   again this copies the hash tables already built in source, which is much
+   faster when many small messages are compressed with one shared preset
+   dictionary: set the dictionary once on a stream kept for that purpose, and
+   then prime each new or reset compression stream from it.  source is not
+   modified, and may be used this way any number of times.  dest keeps its own
+   level, strategy and wrapper; the compressed output is identical to that of
+   the deflateSetDictionary() alternative.
+
+     deflateCopyDictionary returns Z_OK if success, or Z_STREAM_ERROR if either
+   stream state is inconsistent, if dest is writing a gzip stream, if source
+   has been used by deflate() since it was initialized or reset, or if the two
+   streams differ in windowBits, memLevel, or zlib versus raw wrapping.
+*/
+
 ZEXTERN int ZEXPORT deflateCopy OF((z_streamp dest,
                                     z_streamp source));
 /*
@@ -682,9 +747,11 @@ ZEXTERN int ZEXPORT deflateCopy OF((z_streamp dest,
      This function can be useful when several compression strategies will be
    tried, for example when there are several ways of pre-processing the input
    data with a filter.  The streams that will be discarded should then be freed
-   by calling deflateEnd.  Note that deflateCopy duplicates the internal
-   compression state which can be quite large, so this strategy is slow and can
-   consume lots of memory.
+   by calling deflateEnd.  Note that deflateCopy allocates a new internal
+   compression state, which can be quite large, so this strategy can consume
+   lots of memory.  Only the parts of the state in use are copied, which early
+   in a stream is a small fraction of it; see deflateFork() to also avoid the
+   allocation.
 
      deflateCopy returns Z_OK if success, Z_MEM_ERROR if there was not
    enough memory, Z_STREAM_ERROR if the source stream state was inconsistent
@@ -692,6 +759,23 @@ ZEXTERN int ZEXPORT deflateCopy OF((z_streamp dest,
    destination.
 */
 
+ZEXTERN int ZEXPORT deflateFork OF((z_streamp dest,
+                                    z_streamp source));
+/*
+     Makes dest a copy of source like deflateCopy(), but dest must already be
+   a deflate stream, initialized with the same windowBits and memLevel as
+   source, and its memory is reused instead of allocating another state.  The
+   previous state of dest is discarded, but dest keeps its own zalloc, zfree
+   and opaque.  A set of streams can so be forked from one prefix again and
+   again, for example to compress what follows it with several strategies and
+   keep the smallest result, without any allocation after the first time.
+
+     deflateFork returns Z_OK if success, or Z_STREAM_ERROR if either stream
+   state is inconsistent, if dest and source are the same stream, or if they
+   differ in windowBits or memLevel.  msg is left unchanged in both source and
+   destination.
+*/
+
 ZEXTERN int ZEXPORT deflateReset OF((z_streamp strm));
 /*
      This function is equivalent to deflateEnd followed by deflateInit, but
@@ -787,6 +871,21 @@ ZEXTERN int ZEXPORT deflatePending OF((z_streamp strm,
    stream state was inconsistent.
  */
 
+ZEXTERN int ZEXPORT deflateGetStats OF((z_streamp strm,
+                                        z_deflate_stats *stats));
+/*
+     deflateGetStats() copies the counters accumulated since the last
+   deflateInit2() or deflateReset() to *stats.  The counters describe how the
+   compressor spent its effort, which is useful when choosing the parameters
+   of deflateTune().  They are only kept when zlib is compiled with ZLIB_STATS
+   defined, which can be checked with bit 23 of zlibCompileFlags().  Without
+   it, keeping them costs nothing and this function always fails.
+
+     deflateGetStats returns Z_OK if success, or Z_STREAM_ERROR if the source
+   stream state was inconsistent, stats is Z_NULL, or zlib was compiled
+   without ZLIB_STATS.
+*/
+
 ZEXTERN int ZEXPORT deflatePrime OF((z_streamp strm,
                                      int bits,
                                      int value));
@@ -1067,6 +1166,52 @@ ZEXTERN int ZEXPORT inflateGetHeader OF((z_streamp strm,
    stream state was inconsistent.
 */
 
+ZEXTERN int ZEXPORT inflateGetStats OF((z_streamp strm,
+                                        z_inflate_stats *stats));
+/*
+     inflateGetStats() copies the counters accumulated since the last
+   inflateInit2() or inflateReset() to *stats.  fast_out and slow_out split
+   the bytes written so far between inflate_fast() and the code by code state
+   machine in inflate(), which also copies stored blocks.  A large slow_out
+   for compressed blocks usually means that the input or output buffers given
+   to inflate() are too small for the fast path to be taken.
+   As with deflateGetStats(), the counters are only kept when zlib is compiled
+   with ZLIB_STATS defined.
+
+     inflateGetStats returns Z_OK if success, or Z_STREAM_ERROR if the source
+   stream state was inconsistent, stats is Z_NULL, or zlib was compiled
+   without ZLIB_STATS.
+*/
+
+ZEXTERN int ZEXPORT inflateNoWindow OF((z_streamp strm));
+/*
+     inflateNoWindow() has inflate() look back into the output it has already
+   written instead of keeping its own copy of the last 32K of output, for when
+   all of the output is kept in memory in one piece.  The sliding window is
+   then never allocated and output is never copied into it, which saves up to
+   32K bytes per stream and a copy of each byte of output when inflate() is
+   called more than once.  Without it, inflate() already does without a window
+   if the whole stream is inflated with a single call using Z_FINISH.
+
+     The application must then call inflate() each time with next_out just
+   past the output of the previous call, and must leave that output, up to
+   the window size, in place and unchanged until the end of the stream.  The
+   output may be moved to a larger buffer between calls, as long as next_out
+   is moved with it.  Otherwise inflate() reads the wrong data, or memory
+   before next_out.  inflateGetDictionary() then returns no data, and
+   inflateSetDictionary() can not be used.
+
+     inflateNoWindow() must be called after inflateInit2() or inflateReset()
+   and before the first call of inflate() that writes output.  It lasts until
+   the next inflateReset(), inflateReset2() or successful inflateSync().  A
+   window allocated before for an earlier stream is kept for later use, but
+   not touched.
+
+     inflateNoWindow returns Z_OK if success, or Z_STREAM_ERROR if the source
+   stream state was inconsistent, or if output has already been kept in a
+   window or a dictionary has been set.
+*/
+
 /*
 ZEXTERN int ZEXPORT inflateBackInit OF((z_streamp strm, int windowBits,
                                         unsigned char FAR *window));
@@ -1188,7 +1333,8 @@ ZEXTERN uLong ZEXPORT zlibCompileFlags OF((void));
 
     One-time table building (smaller code, but not thread-safe if true):
      12: BUILDFIXED -- build static block decoding tables when needed
-     13: DYNAMIC_CRC_TABLE -- build CRC calculation tables when needed
+     13: DYNAMIC_CRC_TABLE -- build CRC calculation tables when needed (only
+         with MAKECRCH, else the constant tables are used)
      14,15: 0 (reserved)
 
     Library content (indicates missing functionality):
@@ -1201,7 +1347,8 @@ ZEXTERN uLong ZEXPORT zlibCompileFlags OF((void));
     Operation variations (changes in library functionality):
      20: PKZIP_BUG_WORKAROUND -- slightly more permissive inflate
      21: FASTEST -- deflate algorithm with only one, lowest compression level
-     22,23: 0 (reserved)
+     22: FAST_MATCH -- deflate with a four-byte hash and wide match compares
+     23: ZLIB_STATS -- deflateGetStats() and inflateGetStats() are supported
 
     The sprintf variant used by gzprintf (zero is best):
      24: 0 = vs*, 1 = s* -- 1 means limited to 20 arguments after the format
@@ -1262,6 +1409,70 @@ ZEXTERN uLong ZEXPORT compressBound OF((uLong sourceLen));
    compress() or compress2() call to allocate the destination buffer.
 */
 
+ZEXTERN int ZEXPORT deflateChunk OF((Bytef *dest, uLongf *destLen,
+                                     const Bytef *source, uLong sourceLen,
+                                     const Bytef *dictionary, uInt dictLength,
+                                     int level, int last));
+/*
+     Compresses the source buffer into the destination buffer as one chunk of
+   a raw deflate stream, for compressing a large input in pieces that do not
+   depend on each other, e.g. on several threads at once.  The dictionary, if
+   dictLength is not zero, should be the up to 32K bytes of uncompressed data
+   that precede the chunk in the stream, so that matches can reach back into
+   the previous chunk as if it had been compressed by the same stream.  If
+   last is false, the chunk is ended with a Z_SYNC_FLUSH; otherwise it is
+   ended with the final block.  Chunks compressed this way, in order and with
+   only the last one having last set, concatenate into a single valid raw
+   deflate stream that any inflater can decode.  The caller adds the zlib or
+   gzip header and trailer; the check value of the whole stream can be put
+   together from the check values of the chunks with adler32_combine() or
+   crc32_combine().
+
+     Upon entry, destLen is the total size of the destination buffer, which
+   must be at least the value returned by deflateChunkBound(sourceLen).  Upon
+   exit, destLen is the actual size of the compressed chunk.  The level
+   parameter has the same meaning as in deflateInit.
+
+     deflateChunk returns Z_OK if success, Z_MEM_ERROR if there was not enough
+   memory, Z_BUF_ERROR if there was not enough room in the output buffer,
+   Z_STREAM_ERROR if the level parameter is invalid.
+*/
+
+ZEXTERN uLong ZEXPORT deflateChunkBound OF((uLong sourceLen));
+/*
+     deflateChunkBound() returns an upper bound on the compressed size after
+   deflateChunk() on sourceLen bytes.
+*/
+
+ZEXTERN int ZEXPORT deflateBatch OF((z_streamp strm, unsigned count,
+                                     const Bytef * const *sources,
+                                     const uLong *sourceLens,
+                                     Bytef *dest, uLongf *destLen,
+                                     uLongf *offsets));
+/*
+     Compresses count buffers with the one deflate stream strm, which must
+   have been initialized with deflateInit() or deflateInit2().  Each buffer,
+   sources[i] of sourceLens[i] bytes, is compressed into a complete stream of
+   its own, with the header and trailer selected by windowBits, and the
+   streams are put one after another into dest.  The stream is reset with
+   deflateReset() before each buffer, so its memory is allocated once for the
+   whole batch.  After a short buffer, the reset clears only the hash table
+   entries that the buffer used, which is much less work than clearing the
+   whole table, so batches of small messages compress a lot faster than with
+   a deflateInit() and deflateEnd() or compress2() for each.
+
+     Upon entry, destLen is the total size of the destination buffer, which
+   is large enough if it is at least the sum of deflateBound(strm,
+   sourceLens[i]) over the buffers.  offsets must have room for count + 1
+   values.  Upon exit, offsets[i] is where the stream of buffer i starts in
+   dest, offsets[count] and destLen are the total size of the compressed data.
+
+     deflateBatch returns Z_OK if success, Z_BUF_ERROR if there was not enough
+   room in the output buffer, or Z_STREAM_ERROR if the stream state was
+   inconsistent.  In case of an error, destLen and the offsets up to the
+   failing buffer are those of the buffers that were completed.
+*/
+
 ZEXTERN int ZEXPORT uncompress OF((Bytef *dest,   uLongf *destLen,
                                    const Bytef *source, uLong sourceLen));
 /*
@@ -1305,8 +1516,10 @@ ZEXTERN gzFile ZEXPORT gzopen OF((const char *path, const char *mode));
      Opens a gzip (.gz) file for reading or writing.  The mode parameter is as
    in fopen ("rb" or "wb") but can also include a compression level ("wb9") or
    a strategy: 'f' for filtered data as in "wb6f", 'h' for Huffman-only
-   compression as in "wb1h", 'R' for run-length encoding as in "wb1R", or 'F'
-   for fixed code compression as in "wb9F".  (See the description of
+   compression as in "wb1h", 'R' for run-length encoding as in "wb1R", 'F'
+   for fixed code compression as in "wb9F", 'Q' or 'M' for the quick or
+   medium strategies as in "wbQ", or 'A' for the adaptive strategy as in
+   "wb6A".  (See the description of
    deflateInit2 for more information about the strategy parameter.)  'T' will
    request transparent writing or appending with no compression and not using
    the gzip format.
@@ -1318,6 +1531,14 @@ ZEXTERN gzFile ZEXPORT gzopen OF((const char *path, const char *mode));
    already exists.  On systems that support it, the addition of "e" when
    reading or writing will set the flag to close the file on an execve() call.
 
+     'B' when writing compresses in a background thread: gzwrite() and the
+   other writing functions copy each filled buffer for the thread and return
+   while it is compressed and written, so the application can go on producing
+   data.  gzflush(), gzsetparams(), and gzclose() wait for the thread to finish
+   what it was given, and report an error from it; an earlier write error may
+   only be reported there.  'B' is ignored if zlib was built without thread
+   support.
+
      These functions, as well as gzip, will read and decode a sequence of gzip
    streams in a file.  The append function of gzopen() can be used to create
    such a file.  (Also see gzflush() for another way to do this.)  When
@@ -1363,12 +1584,14 @@ ZEXTERN gzFile ZEXPORT gzdopen OF((int fd, const char *mode));
 ZEXTERN int ZEXPORT gzbuffer OF((gzFile file, unsigned size));
 /*
      Set the internal buffer size used by this library's functions.  The
-   default buffer size is 8192 bytes.  This function must be called after
-   gzopen() or gzdopen(), and before any other calls that read or write the
-   file.  The buffer memory allocation is always deferred to the first read or
-   write.  Three times that size in buffer space is allocated.  A larger buffer
-   size of, for example, 64K or 128K bytes will noticeably increase the speed
-   of decompression (reading).
+   default buffer size is 128K bytes, or the preferred block size of the file
+   if that is larger, up to 1M bytes.  When a regular file is opened for
+   reading, the default is reduced to what the file needs, but to no less than
+   8K bytes.  This function must be called after gzopen() or gzdopen(), and
+   before any other calls that read or write the file.  The buffer memory
+   allocation is always deferred to the first read or write.  Three times that
+   size in buffer space is allocated.  A smaller buffer saves memory when many
+   files are open at once, at the cost of more read() or write() calls.
 
      The new buffer size also affects the maximum length for gzprintf().
 
@@ -1627,6 +1850,43 @@ ZEXTERN int ZEXPORT gzdirect OF((gzFile file));
    gzip file reading and decompression, which may not be desired.)
 */
 
+ZEXTERN int ZEXPORT gzbuildindex OF((gzFile file, unsigned long span));
+/*
+     Builds a random access index for a file being read, so that later
+   gzseek() calls jump to the closest preceding access point instead of
+   decompressing everything from the start.  The whole file is decompressed
+   once, and an access point is noted at the first deflate block boundary and
+   then at the first one following each span uncompressed bytes.  A span of
+   zero selects 1 MB.  Each access point holds a copy of the preceding 32K of
+   uncompressed data, so the index takes 32K of memory per access point.  The
+   current read position and buffered data are not disturbed.
+
+     Concatenated gzip members are indexed as gzread() would decompress them.
+   When reading resumes from an access point, the check value of that member
+   cannot be verified, since data before the access point is not decoded.
+
+     gzbuildindex() returns the number of access points, zero if the file
+   contains no gzip data (seeking in a transparently read file is already
+   cheap), or -1 on error, in which case gzerror() reports the error.  Any
+   previous index for file is replaced.  The index is freed by gzclose().
+*/
+
+ZEXTERN int ZEXPORT gzsaveindex OF((gzFile file, const char *path));
+/*
+     Writes the index built by gzbuildindex() or read by gzloadindex() to the
+   side file path, so that later runs can avoid building it again.  Returns 0
+   on success, or -1 if file has no index or path could not be written.
+*/
+
+ZEXTERN int ZEXPORT gzloadindex OF((gzFile file, const char *path));
+/*
+     Reads an index written by gzsaveindex() from path, and uses it for
+   gzseek() on file as if it had been built by gzbuildindex().  The index must
+   have been built for a file of the same length.  Returns the number of
+   access points, or -1 if path could not be read or does not hold a matching
+   index, in which case file is left unchanged.
+*/
+
 ZEXTERN int ZEXPORT    gzclose OF((gzFile file));
 /*
      Flushes all pending output if necessary, closes the compressed file and
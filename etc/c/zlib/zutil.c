@@ -70,7 +70,7 @@ uLong ZEXPORT zlibCompileFlags()
 #ifdef BUILDFIXED
     flags += 1 << 12;
 #endif
-#ifdef DYNAMIC_CRC_TABLE
+#if defined(DYNAMIC_CRC_TABLE) && defined(MAKECRCH)
     flags += 1 << 13;
 #endif
 #ifdef NO_GZCOMPRESS
@@ -85,6 +85,12 @@ uLong ZEXPORT zlibCompileFlags()
 #ifdef FASTEST
     flags += 1L << 21;
 #endif
+#if defined(FAST_MATCH) && !defined(FASTEST) && !defined(ASMV)
+    flags += 1L << 22;
+#endif
+#ifdef ZLIB_STATS
+    flags += 1L << 23;
+#endif
 #if defined(STDC) || defined(Z_HAVE_STDARG_H)
 #  ifdef NO_vsnprintf
     flags += 1L << 25;
@@ -127,6 +133,99 @@ void ZLIB_INTERNAL z_error (m)
 }
 #endif
 
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+
+#ifdef Z_X86_SIMD
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+#if defined(Z_ARM_SIMD) && defined(__linux__)
+#  include <sys/auxv.h>
+#  ifndef HWCAP_CRC32
+#    define HWCAP_CRC32 (1 << 7)
+#  endif
+#endif
+
+/* Features are probed on the first call and cached.  Concurrent first calls
+   may all do the probing, but they store the same value, so no lock is
+   needed.  The value 0 means not probed yet, hence the extra bit. */
+#define Z_CPU_PROBED 0x8000
+
+local volatile int cpu_features = 0;
+
+int ZLIB_INTERNAL z_cpu_features()
+{
+    int features;
+
+    features = cpu_features;
+    if (features)
+        return features & ~Z_CPU_PROBED;
+    features = Z_CPU_PROBED;
+
+#ifdef Z_X86_SIMD
+    {
+        unsigned max, ecx, edx1, ebx7, xcr0;
+#  ifdef _MSC_VER
+        int regs[4];
+
+        __cpuid(regs, 0);
+        max = (unsigned)regs[0];
+        ecx = edx1 = ebx7 = xcr0 = 0;
+        if (max >= 1) {
+            __cpuid(regs, 1);
+            ecx = (unsigned)regs[2];
+            edx1 = (unsigned)regs[3];
+        }
+        if (max >= 7) {
+            __cpuidex(regs, 7, 0);
+            ebx7 = (unsigned)regs[1];
+        }
+        if (ecx & (1 << 27))            /* OSXSAVE */
+            xcr0 = (unsigned)_xgetbv(0);
+#  else
+        unsigned eax, ebx, edx;
+
+        max = __get_cpuid_max(0, 0);
+        ecx = edx1 = ebx7 = xcr0 = 0;
+        if (max >= 1)
+            __cpuid(1, eax, ebx, ecx, edx1);
+        if (max >= 7)
+            __cpuid_count(7, 0, eax, ebx7, ebx, edx);
+        if (ecx & (1 << 27))            /* OSXSAVE */
+            __asm__ ("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+#  endif
+        if (edx1 & (1 << 26))
+            features |= Z_CPU_SSE2;
+        if (ecx & (1 << 19))
+            features |= Z_CPU_SSE41;
+        if (ecx & (1 << 1))
+            features |= Z_CPU_PCLMUL;
+        if (ecx & (1 << 9))
+            features |= Z_CPU_SSSE3;
+        if ((ebx7 & (1 << 5)) && (xcr0 & 6) == 6)
+            features |= Z_CPU_AVX2;
+    }
+#endif /* Z_X86_SIMD */
+
+#ifdef Z_ARM_SIMD
+#  ifdef __APPLE__
+    /* every 64-bit Apple processor implements the optional CRC32 set */
+    features |= Z_CPU_ARMCRC;
+#  else
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+        features |= Z_CPU_ARMCRC;
+#  endif
+#endif /* Z_ARM_SIMD */
+
+    cpu_features = features;
+    return features & ~Z_CPU_PROBED;
+}
+
+#endif /* Z_X86_SIMD || Z_ARM_SIMD */
+
 /* exported to allow conversion of error code to string for compress() and
  * uncompress()
  */
@@ -268,4 +268,54 @@ extern z_const char * const z_errmsg[10]; /* indexed by 2-zlib_error */
 #define ZSWAP32(q) ((((q) >> 24) & 0xff) + (((q) >> 8) & 0xff00) + \
                     (((q) & 0xff00) << 8) + (((q) & 0xff) << 24))
 
+/* Hardware acceleration.  Z_X86_SIMD or Z_ARM_SIMD is defined when the
+   compiler can generate code for instruction set extensions that are not
+   part of the baseline target.  Such code is only run after z_cpu_features()
+   has confirmed that the processor supports it.  Compile with -DNO_SIMD to
+   use the portable C code only. */
+#if !defined(NO_SIMD) && !defined(Z_SOLO)
+#  if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+      (defined(__clang__) || __GNUC__ > 4 || \
+       (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#    define Z_X86_SIMD
+#    define Z_TARGET(isa) __attribute__((target(isa)))
+#  elif defined(_MSC_VER) && !defined(__DMC__) && \
+        (defined(_M_X64) || defined(_M_IX86)) && _MSC_VER >= 1600
+#    define Z_X86_SIMD
+#    define Z_TARGET(isa)
+#  elif defined(__GNUC__) && defined(__aarch64__) && \
+        (defined(__linux__) || defined(__APPLE__)) && \
+        (defined(__clang__) || __GNUC__ > 5)
+#    define Z_ARM_SIMD
+#    define Z_TARGET(isa) __attribute__((target(isa)))
+#  endif
+#endif
+
+/* bits returned by z_cpu_features() */
+#define Z_CPU_SSE41     0x0001  /* x86 SSE4.1 */
+#define Z_CPU_PCLMUL    0x0002  /* x86 carry-less multiply (PCLMULQDQ) */
+#define Z_CPU_SSSE3     0x0004  /* x86 SSSE3 */
+#define Z_CPU_AVX2      0x0008  /* x86 AVX2, with OS support for ymm state */
+#define Z_CPU_SSE2      0x0010  /* x86 SSE2, always there on x86-64 */
+#define Z_CPU_ARMCRC    0x0100  /* ARMv8 CRC32 instructions */
+
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+   typedef unsigned long long z_u64;   /* all such compilers have it */
+   int ZLIB_INTERNAL z_cpu_features OF((void));
+#else
+#  define z_cpu_features() 0
+#endif
+
+/* Alignment for a constant table, put at the start of its definition.  The
+   large tables are aligned to Z_CACHELINE so that each is spread over as few
+   cache lines as possible. */
+#if defined(_MSC_VER) && !defined(__DMC__)
+#  define Z_ALIGNED(n) __declspec(align(n))
+#elif defined(__GNUC__)
+#  define Z_ALIGNED(n) __attribute__((aligned(n)))
+#else
+#  define Z_ALIGNED(n)
+#endif
+#define Z_CACHELINE 64
+
 #endif /* ZUTIL_H */
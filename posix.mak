@@ -107,7 +107,10 @@ endif
 OUTFILEFLAG = -o
 NODEFAULTLIB=-defaultlib= -debuglib=
 ifeq (,$(findstring win,$(OS)))
-	CFLAGS=$(MODEL_FLAG) -fPIC -DHAVE_UNISTD_H
+	CFLAGS=$(MODEL_FLAG) -fPIC -DHAVE_UNISTD_H -DINFLATE_WIDE_TABLES
+	ifeq ($(MODEL),64)
+		CFLAGS += -DINFLATE_FAST64 -DDEFLATE_BITS64
+	endif
 	NODEFAULTLIB += -L-lpthread -L-lm
 	ifeq ($(BUILD),debug)
 		CFLAGS += -g
@@ -442,6 +445,20 @@ unittest/%.run : $(ROOT)/unittest/test_runner
 %.debug : %.d
 	 BUILD=debug $(MAKE) -f $(MAKEFILE) $(basename $<).debug_with_debugger
 
+################################################################################
+# zlib benchmark: speed and ratio of each level and strategy, written as JSON to
+# $(ROOT)/zbench.json. Use BENCHFLAGS="file ..." to measure on your own corpus.
+################################################################################
+
+ZBENCH = $(ROOT)/zbench$(DOTEXE)
+
+$(ZBENCH): etc/c/zlib/zbench.c $(OBJS)
+	$(CC) $(CFLAGS) etc/c/zlib/zbench.c $(OBJS) -o $@ -lpthread
+
+.PHONY: zlib-bench
+zlib-bench: $(ZBENCH)
+	$(ZBENCH) $(BENCHFLAGS) > $(ROOT)/zbench.json
+
 ################################################################################
 # More stuff
 ################################################################################